@@ -0,0 +1,393 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+// id3v2_bench runs every benchmark over synthetic corpora and prints one JSON object per result line:
+//   {"corpus":"v2.3","benchmark":"load","files":..., "bytes":..., "seconds":..., "mb_per_second":...,
+//    "files_per_second":..., "allocations_per_file":...}
+// bytes are the file sizes for the scan and load benchmarks and the tag sizes for the others.
+// allocations_per_file is -1 where allocations can't be counted, which needs a linker supporting --wrap.
+//
+// usage: id3v2_bench [--files N] [--min-time SECONDS] [--corpus NAME] [--seed N] [--write-corpus DIRECTORY]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+#include "corpus.h"
+
+static corpus_options corpora[] =
+{
+    // name                 version frames min  max   picture encoding                        unsync exthdr padding tags audio
+    { "v2.2",               2,      12,    8,   256,  0,      ID3V2_ISO_ENCODING,             0,     0,     0,      1,   4096 },
+    { "v2.3",               3,      12,    8,   256,  0,      ID3V2_ISO_ENCODING,             0,     0,     0,      1,   4096 },
+    { "v2.3-utf16",         3,      12,    8,   512,  0,      ID3V2_UTF_16_ENCODING_WITH_BOM, 0,     0,     0,      1,   4096 },
+    { "v2.3-picture",       3,      8,     8,   256,  65536,  ID3V2_ISO_ENCODING,             0,     0,     0,      1,   4096 },
+    { "v2.3-unsync",        3,      12,    8,   256,  16384,  ID3V2_UTF_16_ENCODING_WITH_BOM, 1,     1,     0,      1,   4096 },
+    { "v2.4-utf8",          4,      24,    8,   1024, 0,      ID3V2_UTF_8_ENCODING,           0,     0,     0,      1,   4096 },
+    { "v2.4-unsync",        4,      12,    8,   256,  16384,  ID3V2_UTF_8_ENCODING,           1,     1,     0,      1,   4096 },
+    { "v2.4-padded-multi",  4,      12,    8,   256,  0,      ID3V2_UTF_8_ENCODING,           0,     0,     4096,   2,   4096 },
+};
+#define CORPORA (sizeof(corpora) / sizeof(corpora[0]))
+
+typedef struct
+{
+    char **files;
+    size_t *sizes;
+    id3v2_tag **tags;
+    int64_t *tag_sizes;
+    int count;
+    char *text; // UTF-8 scratch buffer of the decode benchmark
+    int text_size;
+} corpus;
+
+typedef int64_t (*benchmark)(corpus *corpus, int index);
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+// the linker routes the allocations of the library through these
+static int64_t allocations = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size)
+{
+    allocations++;
+    return __real_realloc(pointer, size);
+}
+#define GET_ALLOCATIONS() allocations
+#else
+#define GET_ALLOCATIONS() -1
+#endif
+
+static int64_t _scan_headers(corpus *corpus, int index)
+{
+    int count = 0;
+    int64_t *offsets = NULL;
+
+    _find_header_offsets_in_buffer(corpus->files[index], corpus->sizes[index], &offsets, &count);
+    free(offsets);
+
+    return (int64_t)corpus->sizes[index];
+}
+
+static int64_t _load_tag(corpus *corpus, int index)
+{
+    id3v2_tag *tag = id3v2_load_tag_from_buffer(corpus->files[index], corpus->sizes[index]);
+
+    if(tag != NULL)
+        id3v2_free_tag(tag);
+
+    return (int64_t)corpus->sizes[index];
+}
+
+static int64_t _load_tags(corpus *corpus, int index)
+{
+    int count = 0;
+    int i;
+    id3v2_tag **tags = NULL;
+
+    id3v2_load_tags_from_buffer(corpus->files[index], corpus->sizes[index], &tags, &count);
+
+    for(i = 0; i < count; i++)
+    {
+        if(tags[i] != NULL)
+            id3v2_free_tag(tags[i]);
+    }
+    free(tags);
+
+    return (int64_t)corpus->sizes[index];
+}
+
+static int64_t _get_frames(corpus *corpus, int index)
+{
+    id3v2_tag *tag = corpus->tags[index];
+    volatile int found = 0;
+
+    if(tag == NULL)
+        return 0;
+
+    found += id3v2_get_title_frame_from_tag(tag) != NULL;
+    found += id3v2_get_artist_frame_from_tag(tag) != NULL;
+    found += id3v2_get_album_frame_from_tag(tag) != NULL;
+    found += id3v2_get_album_artist_frame_from_tag(tag) != NULL;
+    found += id3v2_get_genre_frame_from_tag(tag) != NULL;
+    found += id3v2_get_track_frame_from_tag(tag) != NULL;
+    found += id3v2_get_year_frame_from_tag(tag) != NULL;
+    found += id3v2_get_comment_frame_from_tag(tag) != NULL;
+    found += id3v2_get_disc_number_frame_from_tag(tag) != NULL;
+    found += id3v2_get_composer_frame_from_tag(tag) != NULL;
+
+    return corpus->tag_sizes[index];
+}
+
+static int64_t _decode_text(corpus *corpus, int index)
+{
+    char encoding;
+    id3v2_frame *frame;
+    char *resized;
+    int size;
+    char *text;
+
+    if(corpus->tags[index] == NULL)
+        return 0;
+
+    for(frame = corpus->tags[index]->frame; frame != NULL; frame = frame->next)
+    {
+        if(id3v2_get_frame_type(frame) != ID3V2_TEXT_FRAME && id3v2_get_frame_type(frame) != ID3V2_COMMENT_FRAME)
+            continue;
+
+        id3v2_get_text_from_frame(frame, &text, &size, &encoding);
+
+        if(size <= 0)
+            continue;
+
+        if(size * 2 > corpus->text_size)
+        {
+            if((resized = (char*)realloc(corpus->text, size * 2)) == NULL)
+                continue;
+            corpus->text = resized;
+            corpus->text_size = size * 2;
+        }
+
+        _convert_text_to_utf8(text, size, encoding, corpus->text);
+    }
+
+    return corpus->tag_sizes[index];
+}
+
+static int64_t _write_tag(corpus *corpus, int index)
+{
+    char *buffer;
+    size_t size;
+
+    if(corpus->tags[index] == NULL)
+        return 0;
+
+    buffer = id3v2_write_tag_to_buffer(corpus->tags[index], &size);
+    free(buffer);
+
+    return corpus->tag_sizes[index];
+}
+
+static int64_t _write_snapshot(corpus *corpus, int index)
+{
+    char *buffer;
+    size_t size;
+
+    if(corpus->tags[index] == NULL)
+        return 0;
+
+    buffer = id3v2_write_snapshot_to_buffer(&corpus->tags[index], 1, &size);
+    free(buffer);
+
+    return corpus->tag_sizes[index];
+}
+
+static struct
+{
+    const char *name;
+    benchmark run;
+} benchmarks[] =
+{
+    { "scan", _scan_headers },
+    { "load", _load_tag },
+    { "load_all", _load_tags },
+    { "get", _get_frames },
+    { "decode", _decode_text },
+    { "write", _write_tag },
+    { "snapshot", _write_snapshot },
+};
+#define BENCHMARKS (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+static int _generate_corpus(corpus_options *options, int count, uint32_t seed, corpus *corpus)
+{
+    int i;
+
+    memset(corpus, 0, sizeof(*corpus));
+    corpus->files = (char**)calloc(count, sizeof(char*));
+    corpus->sizes = (size_t*)calloc(count, sizeof(size_t));
+    corpus->tags = (id3v2_tag**)calloc(count, sizeof(id3v2_tag*));
+    corpus->tag_sizes = (int64_t*)calloc(count, sizeof(int64_t));
+
+    if(corpus->files == NULL || corpus->sizes == NULL || corpus->tags == NULL || corpus->tag_sizes == NULL)
+        return 0;
+
+    corpus->count = count;
+
+    for(i = 0; i < count; i++)
+    {
+        corpus->files[i] = generate_corpus_file(options, &seed, &corpus->sizes[i]);
+        if(corpus->files[i] == NULL)
+            return 0;
+
+        // the getters, decoders and writers work on tags loaded up front
+        corpus->tags[i] = id3v2_load_tag_from_buffer(corpus->files[i], corpus->sizes[i]);
+        if(corpus->tags[i] != NULL)
+            corpus->tag_sizes[i] = ID3V2_HEADER + corpus->tags[i]->header->tag_size;
+    }
+
+    return 1;
+}
+
+static void _free_corpus(corpus *corpus)
+{
+    int i;
+
+    for(i = 0; i < corpus->count; i++)
+    {
+        free(corpus->files[i]);
+        if(corpus->tags[i] != NULL)
+            id3v2_free_tag(corpus->tags[i]);
+    }
+
+    free(corpus->files);
+    free(corpus->sizes);
+    free(corpus->tags);
+    free(corpus->tag_sizes);
+    free(corpus->text);
+}
+
+static void _run_benchmark(const char *corpus_name, corpus *corpus, int index, double min_time)
+{
+    int64_t allocations_before;
+    int64_t allocations_counted;
+    int64_t bytes = 0;
+    int64_t files = 0;
+    int i;
+    int64_t start;
+    double seconds;
+
+    // one pass to warm up and count the allocations, then as many as fit into the minimum time
+    allocations_before = GET_ALLOCATIONS();
+    for(i = 0; i < corpus->count; i++)
+        benchmarks[index].run(corpus, i);
+    allocations_counted = GET_ALLOCATIONS() - allocations_before;
+
+    start = _get_monotonic_nanoseconds();
+
+    do
+    {
+        for(i = 0; i < corpus->count; i++)
+            bytes += benchmarks[index].run(corpus, i);
+        files += corpus->count;
+        seconds = (double)(_get_monotonic_nanoseconds() - start) / 1e9;
+    } while(seconds < min_time);
+
+    printf("{\"corpus\":\"%s\",\"benchmark\":\"%s\",\"files\":%lld,\"bytes\":%lld,\"seconds\":%.6f,"
+           "\"mb_per_second\":%.3f,\"files_per_second\":%.1f,\"allocations_per_file\":%.3f}\n",
+           corpus_name, benchmarks[index].name, (long long)files, (long long)bytes, seconds,
+           (double)bytes / (1024.0 * 1024.0) / seconds, (double)files / seconds,
+           GET_ALLOCATIONS() < 0 ? -1.0 : (double)allocations_counted / corpus->count);
+    fflush(stdout);
+}
+
+static int _write_corpus(const char *directory, corpus *corpus, const char *name)
+{
+    FILE *file;
+    int i;
+    char path[4096];
+
+    for(i = 0; i < corpus->count; i++)
+    {
+        snprintf(path, sizeof(path), "%s/%s-%06d.mp3", directory, name, i);
+
+        if((file = fopen(path, "wb")) == NULL)
+        {
+            fprintf(stderr, "unable to write %s\n", path);
+            return 0;
+        }
+
+        fwrite(corpus->files[i], 1, corpus->sizes[i], file);
+        fclose(file);
+    }
+
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    corpus corpus;
+    int count = 1000;
+    const char *directory = NULL;
+    int i;
+    size_t j;
+    double min_time = 0.5;
+    const char *only = NULL;
+    uint32_t seed = 0x1D3F00D;
+
+    for(i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--files") == 0 && i + 1 < argc)
+            count = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+            min_time = atof(argv[++i]);
+        else if(strcmp(argv[i], "--corpus") == 0 && i + 1 < argc)
+            only = argv[++i];
+        else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = (uint32_t)strtoul(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "--write-corpus") == 0 && i + 1 < argc)
+            directory = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--files N] [--min-time SECONDS] [--corpus NAME] [--seed N] [--write-corpus DIRECTORY]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(count <= 0 || seed == 0)
+    {
+        fprintf(stderr, "the file count and the seed need to be positive\n");
+        return 1;
+    }
+
+    for(j = 0; j < CORPORA; j++)
+    {
+        if(only != NULL && strcmp(only, corpora[j].name) != 0)
+            continue;
+
+        if(!_generate_corpus(&corpora[j], count, seed, &corpus))
+        {
+            fprintf(stderr, "unable to generate the %s corpus\n", corpora[j].name);
+            _free_corpus(&corpus);
+            return 1;
+        }
+
+        if(directory != NULL)
+        {
+            if(!_write_corpus(directory, &corpus, corpora[j].name))
+            {
+                _free_corpus(&corpus);
+                return 1;
+            }
+        }
+        else
+        {
+            for(i = 0; i < (int)BENCHMARKS; i++)
+                _run_benchmark(corpora[j].name, &corpus, i, min_time);
+        }
+
+        _free_corpus(&corpus);
+    }
+
+    return 0;
+}
@@ -0,0 +1,346 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+#include "corpus.h"
+
+static const char *text_frame_ids[] = { "TIT2", "TPE1", "TALB", "TPE2", "TCON", "TRCK", "TYER", "TCOM", "TPOS", "COMM" };
+static const char *text_frame_ids2[] = { "TT2", "TP1", "TAL", "TP2", "TCO", "TRK", "TYE", "TCM", "TPA", "COM" };
+#define TEXT_FRAME_IDS (sizeof(text_frame_ids) / sizeof(text_frame_ids[0]))
+
+typedef struct
+{
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+} corpus_buffer;
+
+static uint32_t _get_random_number(uint32_t *seed)
+{
+    // xorshift32, fast and good enough to fill frames
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+static unsigned char *_reserve_in_corpus_buffer(corpus_buffer *buffer, size_t size)
+{
+    unsigned char *resized;
+    size_t capacity;
+
+    if(buffer->size + size > buffer->capacity)
+    {
+        capacity = buffer->capacity > 0 ? buffer->capacity : 4096;
+        while(capacity < buffer->size + size)
+            capacity *= 2;
+
+        resized = (unsigned char*)realloc(buffer->data, capacity);
+        if(resized == NULL)
+            return NULL;
+
+        buffer->data = resized;
+        buffer->capacity = capacity;
+    }
+
+    buffer->size += size;
+
+    return buffer->data + buffer->size - size;
+}
+
+static int _append_to_corpus_buffer(corpus_buffer *buffer, const void *data, size_t size)
+{
+    unsigned char *target = _reserve_in_corpus_buffer(buffer, size);
+
+    if(target == NULL)
+        return 0;
+
+    if(size > 0)
+        memcpy(target, data, size);
+
+    return 1;
+}
+
+static void _write_size(unsigned char *buffer, int size, int bytes, char syncsafe)
+{
+    int i;
+
+    for(i = bytes - 1; i >= 0; i--)
+    {
+        buffer[i] = (unsigned char)(size & (syncsafe ? 0x7F : 0xFF));
+        size >>= syncsafe ? 7 : 8;
+    }
+}
+
+// inserts a zero byte behind every 0xFF which is followed by a byte that could be mistaken for a sync, or nothing
+static int _unsynchronise_corpus_buffer(corpus_buffer *buffer, size_t start)
+{
+    corpus_buffer result = { NULL, 0, 0 };
+    size_t i;
+
+    for(i = start; i < buffer->size; i++)
+    {
+        if(!_append_to_corpus_buffer(&result, buffer->data + i, 1) ||
+           (buffer->data[i] == 0xFF && (i + 1 == buffer->size || buffer->data[i+1] >= 0xE0 || buffer->data[i+1] == 0x00) &&
+            !_append_to_corpus_buffer(&result, "\0", 1)))
+        {
+            free(result.data);
+            return 0;
+        }
+    }
+
+    buffer->size = start;
+
+    if(!_append_to_corpus_buffer(buffer, result.data, result.size))
+    {
+        free(result.data);
+        return 0;
+    }
+
+    free(result.data);
+
+    return 1;
+}
+
+// log-uniform, so small frames dominate like in real tags while some get large
+static int _get_frame_size(corpus_options *options, uint32_t *seed)
+{
+    int high = options->max_frame_size;
+    int low = options->min_frame_size;
+    int shift = 0;
+
+    while((low << (shift + 1)) <= high && (low << (shift + 1)) > 0)
+        shift++;
+
+    low <<= _get_random_number(seed) % (shift + 1);
+    if(low * 2 < high)
+        high = low * 2;
+
+    return low + (int)(_get_random_number(seed) % (uint32_t)(high - low + 1));
+}
+
+static int _append_text(corpus_buffer *buffer, char encoding, int size, uint32_t *seed)
+{
+    unsigned char *text;
+    int i;
+
+    if(size <= 0)
+        return 1;
+
+    if(encoding == ID3V2_UTF_16_ENCODING_WITH_BOM)
+    {
+        size &= ~1;
+        if(size < 2)
+            return 1;
+        if((text = _reserve_in_corpus_buffer(buffer, size)) == NULL)
+            return 0;
+        text[0] = 0xFF;
+        text[1] = 0xFE;
+        for(i = 2; i < size; i += 2)
+        {
+            text[i] = (unsigned char)('a' + _get_random_number(seed) % 26);
+            text[i+1] = 0;
+        }
+        return 1;
+    }
+
+    if((text = _reserve_in_corpus_buffer(buffer, size)) == NULL)
+        return 0;
+
+    for(i = 0; i < size; i++)
+        text[i] = (unsigned char)('a' + _get_random_number(seed) % 26);
+
+    return 1;
+}
+
+static int _append_frame(corpus_options *options, corpus_buffer *buffer, int index, int size, uint32_t *seed)
+{
+    char comment = index % TEXT_FRAME_IDS == TEXT_FRAME_IDS - 1;
+    size_t data_start;
+    unsigned char *header;
+    int header_size = options->version == ID3V2_2 ? ID3V2_FRAME_ID2 + ID3V2_FRAME_SIZE2 : ID3V2_FRAME;
+    size_t start = buffer->size;
+
+    if((header = _reserve_in_corpus_buffer(buffer, header_size)) == NULL)
+        return 0;
+    memset(header, 0, header_size);
+
+    data_start = buffer->size;
+
+    if(!_append_to_corpus_buffer(buffer, &options->encoding, 1))
+        return 0;
+
+    if(comment && (!_append_to_corpus_buffer(buffer, "eng", ID3V2_FRAME_LANGUAGE) ||
+                   !_append_to_corpus_buffer(buffer, "\0\0", options->encoding == ID3V2_UTF_16_ENCODING_WITH_BOM ? 2 : 1)))
+        return 0;
+
+    if(!_append_text(buffer, options->encoding, size - (int)(buffer->size - data_start), seed))
+        return 0;
+
+    if(options->version == ID3V2_4 && options->unsynchronisation && !_unsynchronise_corpus_buffer(buffer, data_start))
+        return 0;
+
+    header = buffer->data + start;
+
+    if(options->version == ID3V2_2)
+    {
+        memcpy(header, text_frame_ids2[index % TEXT_FRAME_IDS], ID3V2_FRAME_ID2);
+        _write_size(header + ID3V2_FRAME_ID2, (int)(buffer->size - data_start), ID3V2_FRAME_SIZE2, 0);
+    }
+    else
+    {
+        memcpy(header, text_frame_ids[index % TEXT_FRAME_IDS], ID3V2_FRAME_ID);
+        _write_size(header + ID3V2_FRAME_ID, (int)(buffer->size - data_start), ID3V2_FRAME_SIZE, options->version == ID3V2_4);
+        if(options->version == ID3V2_4 && options->unsynchronisation)
+            header[ID3V2_FRAME_ID + ID3V2_FRAME_SIZE + 1] = 0x02;
+    }
+
+    return 1;
+}
+
+static int _append_picture_frame(corpus_options *options, corpus_buffer *buffer, uint32_t *seed)
+{
+    size_t data_start;
+    unsigned char *header;
+    int header_size = options->version == ID3V2_2 ? ID3V2_FRAME_ID2 + ID3V2_FRAME_SIZE2 : ID3V2_FRAME;
+    int i;
+    unsigned char *picture;
+    size_t start = buffer->size;
+
+    if((header = _reserve_in_corpus_buffer(buffer, header_size)) == NULL)
+        return 0;
+    memset(header, 0, header_size);
+
+    data_start = buffer->size;
+
+    if(!_append_to_corpus_buffer(buffer, "\0", 1) ||
+       !(options->version == ID3V2_2 ? _append_to_corpus_buffer(buffer, "JPG", 3) : _append_to_corpus_buffer(buffer, "image/jpeg", 11)) ||
+       !_append_to_corpus_buffer(buffer, "\x03" "\0", 2) ||
+       (picture = _reserve_in_corpus_buffer(buffer, options->picture_size)) == NULL)
+        return 0;
+
+    // random bytes behind a JPEG signature, plenty of 0xFF for the unsynchronisation to deal with
+    for(i = 0; i < options->picture_size; i++)
+        picture[i] = (unsigned char)_get_random_number(seed);
+    if(options->picture_size >= 4)
+        memcpy(picture, "\xFF\xD8\xFF\xE0", 4);
+
+    if(options->version == ID3V2_4 && options->unsynchronisation && !_unsynchronise_corpus_buffer(buffer, data_start))
+        return 0;
+
+    header = buffer->data + start;
+
+    if(options->version == ID3V2_2)
+    {
+        memcpy(header, "PIC", ID3V2_FRAME_ID2);
+        _write_size(header + ID3V2_FRAME_ID2, (int)(buffer->size - data_start), ID3V2_FRAME_SIZE2, 0);
+    }
+    else
+    {
+        memcpy(header, "APIC", ID3V2_FRAME_ID);
+        _write_size(header + ID3V2_FRAME_ID, (int)(buffer->size - data_start), ID3V2_FRAME_SIZE, options->version == ID3V2_4);
+        if(options->version == ID3V2_4 && options->unsynchronisation)
+            header[ID3V2_FRAME_ID + ID3V2_FRAME_SIZE + 1] = 0x02;
+    }
+
+    return 1;
+}
+
+static int _append_tag(corpus_options *options, corpus_buffer *buffer, uint32_t *seed)
+{
+    size_t body_start;
+    unsigned char flags = 0;
+    unsigned char *header;
+    int i;
+    unsigned char *padding;
+    size_t start = buffer->size;
+
+    if(_reserve_in_corpus_buffer(buffer, ID3V2_HEADER) == NULL)
+        return 0;
+
+    body_start = buffer->size;
+
+    if(options->extended_header && options->version != ID3V2_2)
+    {
+        flags |= 0x40;
+        // v2.3 counts the size without itself, v2.4 with itself as syncsafe integer
+        if(!(options->version == ID3V2_3 ? _append_to_corpus_buffer(buffer, "\0\0\0\x06\0\0\0\0\0\0", 10)
+                                         : _append_to_corpus_buffer(buffer, "\0\0\0\x06\x01\0", 6)))
+            return 0;
+    }
+
+    for(i = 0; i < options->frame_count; i++)
+    {
+        if(!_append_frame(options, buffer, i, _get_frame_size(options, seed), seed))
+            return 0;
+    }
+
+    if(options->picture_size > 0 && !_append_picture_frame(options, buffer, seed))
+        return 0;
+
+    if(options->unsynchronisation)
+    {
+        flags |= 0x80;
+        // before v2.4 the whole tag gets unsynchronised, v2.4 does it per frame
+        if(options->version != ID3V2_4 && !_unsynchronise_corpus_buffer(buffer, body_start))
+            return 0;
+    }
+
+    if((padding = _reserve_in_corpus_buffer(buffer, options->padding)) == NULL)
+        return 0;
+    memset(padding, 0, options->padding);
+
+    header = buffer->data + start;
+    memcpy(header, "ID3", ID3V2_HEADER_TAG);
+    header[3] = (unsigned char)options->version;
+    header[4] = 0;
+    header[5] = flags;
+    _write_size(header + 6, (int)(buffer->size - body_start), ID3V2_HEADER_SIZE, 1);
+
+    return 1;
+}
+
+// returns a file made of the described tags followed by random audio bytes, or NULL
+// seed carries the random state from one file to the next, so a corpus is the same on every run
+char *generate_corpus_file(corpus_options *options, uint32_t *seed, size_t *size)
+{
+    unsigned char *audio;
+    corpus_buffer buffer = { NULL, 0, 0 };
+    int i;
+
+    *size = 0;
+
+    for(i = 0; i < options->tags_per_file; i++)
+    {
+        if(!_append_tag(options, &buffer, seed))
+        {
+            free(buffer.data);
+            return NULL;
+        }
+    }
+
+    if((audio = _reserve_in_corpus_buffer(&buffer, options->audio_size)) == NULL)
+    {
+        free(buffer.data);
+        return NULL;
+    }
+
+    // MPEG frame sync followed by bytes which can't be mistaken for a tag
+    for(i = 0; i < options->audio_size; i++)
+        audio[i] = (unsigned char)(0x80 | (_get_random_number(seed) & 0x7F));
+    if(options->audio_size >= 2)
+        memcpy(audio, "\xFF\xFB", 2);
+
+    *size = buffer.size;
+
+    return (char*)buffer.data;
+}
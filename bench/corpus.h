@@ -0,0 +1,35 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_corpus_h
+#define id3v2lib_corpus_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// describes the files of a synthetic corpus
+typedef struct
+{
+    const char *name;
+    int version; // 2, 3 or 4
+    int frame_count; // text and comment frames per tag
+    int min_frame_size; // frame data sizes are spread logarithmically between these two
+    int max_frame_size;
+    int picture_size; // adds an APIC frame with a picture of this size, 0 for none
+    char encoding; // of the text frames, one of the ID3V2_*_ENCODING constants
+    char unsynchronisation;
+    char extended_header;
+    int padding; // zero bytes behind the frames of each tag
+    int tags_per_file;
+    int audio_size; // bytes behind the tags
+} corpus_options;
+
+char *generate_corpus_file(corpus_options *options, uint32_t *seed, size_t *size);
+
+#endif
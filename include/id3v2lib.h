@@ -15,13 +15,47 @@
 #include "id3v2lib/errors.h"
 #include "id3v2lib/header.h"
 #include "id3v2lib/frame.h"
+#include "id3v2lib/kinds.h"
+#include "id3v2lib/decoders.h"
+#include "id3v2lib/index.h"
+#include "id3v2lib/chapters.h"
+#include "id3v2lib/timeline.h"
+#include "id3v2lib/counters.h"
+#include "id3v2lib/patch.h"
 #include "id3v2lib/utils.h"
+#include "id3v2lib/intern.h"
+#include "id3v2lib/images.h"
+#include "id3v2lib/picture.h"
+#include "id3v2lib/id3v1.h"
+#include "id3v2lib/io.h"
+#include "id3v2lib/histogram.h"
+#include "id3v2lib/batch.h"
+#include "id3v2lib/writer.h"
+#include "id3v2lib/cache.h"
+#include "id3v2lib/snapshot.h"
+#include "id3v2lib/export.h"
+#include "id3v2lib/stats.h"
+#include "id3v2lib/trace.h"
 
 int _add_allocation_to_tag(id3v2_tag *tag, void *allocation);
-id3v2_tag* id3v2_load_tag_from_buffer(char* buffer, int length);
+void _parse_frames_into_tag(id3v2_tag *tag, char *bytes, int size, id3v2_load_options *options);
+id3v2_tag* id3v2_load_tag_from_buffer(char* buffer, size_t length);
+id3v2_tag* id3v2_load_tag_from_buffer_with_options(char* buffer, size_t length, id3v2_load_options *options);
 id3v2_tag* id3v2_load_tag_from_file(FILE *file);
-void id3v2_load_tags_from_buffer(char *buffer, int length, id3v2_tag ***tags, int *count);
+id3v2_tag* id3v2_load_tag_from_file_with_options(FILE *file, id3v2_load_options *options);
+id3v2_tag* id3v2_load_tag_from_fd(int fd);
+id3v2_tag* id3v2_load_tag_from_fd_with_options(int fd, id3v2_load_options *options);
+id3v2_tag* id3v2_load_tag_from_io(id3v2_io *io);
+id3v2_tag* id3v2_load_tag_from_io_with_options(id3v2_io *io, id3v2_load_options *options);
+void id3v2_load_tags_from_buffer(char *buffer, size_t length, id3v2_tag ***tags, int *count);
+void id3v2_load_tags_from_buffer_with_options(char *buffer, size_t length, id3v2_tag ***tags, int *count, id3v2_load_options *options);
 void id3v2_load_tags_from_file(FILE *file, id3v2_tag ***tags, int *count);
+void id3v2_load_tags_from_file_with_options(FILE *file, id3v2_tag ***tags, int *count, id3v2_load_options *options);
+void id3v2_load_tags_from_fd(int fd, id3v2_tag ***tags, int *count);
+void id3v2_load_tags_from_fd_with_options(int fd, id3v2_tag ***tags, int *count, id3v2_load_options *options);
+void id3v2_load_tags_from_io(id3v2_io *io, id3v2_tag ***tags, int *count);
+void id3v2_load_tags_from_io_with_options(id3v2_io *io, id3v2_tag ***tags, int *count, id3v2_load_options *options);
+id3v2_tag *id3v2_merge_tags(id3v2_tag **tags, int count);
 //void remove_tag(const char* file_name);
 //void set_tag(const char* file_name, id3v2_tag* tag);
 
@@ -0,0 +1,18 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_batch_h
+#define id3v2lib_batch_h
+
+#include "types.h"
+
+void id3v2_load_batch(const char **paths, int count, id3v2_batch_result *results);
+void id3v2_load_batch_with_options(const char **paths, int count, id3v2_batch_result *results, id3v2_load_options *options);
+
+#endif
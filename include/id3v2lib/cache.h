@@ -0,0 +1,21 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_cache_h
+#define id3v2lib_cache_h
+
+#include "types.h"
+
+id3v2_tag_cache *id3v2_open_tag_cache(const char *path);
+void id3v2_close_tag_cache(id3v2_tag_cache *cache);
+id3v2_tag *id3v2_load_tag_from_path_with_cache(id3v2_tag_cache *cache, const char *path, id3v2_load_options *options);
+void id3v2_get_statistics_from_tag_cache(id3v2_tag_cache *cache, id3v2_tag_cache_statistics *statistics);
+int id3v2_get_entry_count_from_tag_cache(id3v2_tag_cache *cache);
+
+#endif
@@ -0,0 +1,27 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_chapters_h
+#define id3v2lib_chapters_h
+
+#include "types.h"
+
+// chapters, tables of contents and their embedded tags stay valid until the frames of the tag change
+void _free_chapter_index_of_tag(id3v2_tag *tag);
+id3v2_chapter *id3v2_find_chapter_in_tag(id3v2_tag *tag, const char *element_id);
+id3v2_chapter *id3v2_get_chapter_at_time_from_tag(id3v2_tag *tag, uint32_t milliseconds);
+int id3v2_get_chapter_count_from_tag(id3v2_tag *tag);
+id3v2_chapter *id3v2_get_chapter_from_tag(id3v2_tag *tag, int chapter_index);
+id3v2_frame *id3v2_get_picture_frame_from_chapter(id3v2_chapter *chapter);
+id3v2_tag *id3v2_get_tag_from_chapter(id3v2_chapter *chapter);
+id3v2_tag *id3v2_get_tag_from_table_of_contents(id3v2_table_of_contents *table);
+int id3v2_get_table_of_contents_count_from_tag(id3v2_tag *tag);
+id3v2_table_of_contents *id3v2_get_table_of_contents_from_tag(id3v2_tag *tag, int table_index);
+
+#endif
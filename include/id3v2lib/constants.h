@@ -21,6 +21,14 @@
 #define ID3V2_HEADER_SIZE 4
 #define ID3V2_EXTENDED_HEADER_SIZE 4
 
+#define ID3V2_FOOTER 10
+#define ID3V2_BOUNDED_SCAN 65536 // bytes searched behind a tag for further tags if nothing points to them
+#define ID3V1_TAG 128 // trailer at the very end of a file
+#define ID3V1_ENHANCED_TAG 227 // Enhanced TAG+ block in front of the ID3v1 trailer
+#define ID3V2_FIRST_READ 16384 // bytes read at once where a tag is expected, unless a histogram knows better
+#define ID3V2_FIRST_READ_LIMIT 1048576 // tags bigger than this get read in two steps anyway
+#define ID3V2_BATCH_QUEUE_DEPTH 64 // files a batch load keeps in flight at once
+
 #define ID3V2_NO_COMPATIBLE_TAG 0
 #define ID3V2_2  2
 #define ID3V2_3  3
@@ -38,6 +46,7 @@
 #define ID3V2_FRAME_FLAGS 2
 #define ID3V2_FRAME_ENCODING 1
 #define ID3V2_FRAME_LANGUAGE 3
+#define ID3V2_VOLUME_CHANNELS 9 // channel types of RVA2 frames, channels beyond that are ignored
 
 #define ID3V2_UNDEFINED_FRAME -1
 #define ID3V2_INVALID_FRAME 0
@@ -45,6 +54,7 @@
 #define ID3V2_COMMENT_FRAME 2
 #define ID3V2_APIC_FRAME 3
 #define ID3V2_EXPERIMENTAL_FRAME 4
+#define ID3V2_URL_FRAME 5
 
 #define ID3V2_ISO_ENCODING 0 // supported in all tags
 #define ID3V2_UTF_16_ENCODING_WITH_BOM 1 // in all tags possible
@@ -53,6 +63,124 @@
  
 // END TAG_FRAME CONSTANTS
 
+/**
+ * FRAME KINDS
+ * one for every frame ID, the v2.2 frames share the kind of the frame which replaced them
+ */
+enum
+{
+  ID3V2_UNKNOWN_KIND, // not defined by any version, experimental frames included
+  ID3V2_KIND_AENC,
+  ID3V2_KIND_APIC,
+  ID3V2_KIND_ASPI,
+  ID3V2_KIND_CHAP,
+  ID3V2_KIND_COMM,
+  ID3V2_KIND_COMR,
+  ID3V2_KIND_CRM,
+  ID3V2_KIND_CTOC,
+  ID3V2_KIND_ENCR,
+  ID3V2_KIND_EQU2,
+  ID3V2_KIND_EQUA,
+  ID3V2_KIND_ETCO,
+  ID3V2_KIND_GEOB,
+  ID3V2_KIND_GRID,
+  ID3V2_KIND_GRP1,
+  ID3V2_KIND_IPLS,
+  ID3V2_KIND_LINK,
+  ID3V2_KIND_MCDI,
+  ID3V2_KIND_MLLT,
+  ID3V2_KIND_MVIN,
+  ID3V2_KIND_MVNM,
+  ID3V2_KIND_OWNE,
+  ID3V2_KIND_PCNT,
+  ID3V2_KIND_PCST,
+  ID3V2_KIND_POPM,
+  ID3V2_KIND_POSS,
+  ID3V2_KIND_PRIV,
+  ID3V2_KIND_RBUF,
+  ID3V2_KIND_RVA2,
+  ID3V2_KIND_RVAD,
+  ID3V2_KIND_RVRB,
+  ID3V2_KIND_SEEK,
+  ID3V2_KIND_SIGN,
+  ID3V2_KIND_SYLT,
+  ID3V2_KIND_SYTC,
+  ID3V2_KIND_TALB,
+  ID3V2_KIND_TBPM,
+  ID3V2_KIND_TCAT,
+  ID3V2_KIND_TCMP,
+  ID3V2_KIND_TCOM,
+  ID3V2_KIND_TCON,
+  ID3V2_KIND_TCOP,
+  ID3V2_KIND_TDAT,
+  ID3V2_KIND_TDEN,
+  ID3V2_KIND_TDES,
+  ID3V2_KIND_TDLY,
+  ID3V2_KIND_TDOR,
+  ID3V2_KIND_TDRC,
+  ID3V2_KIND_TDRL,
+  ID3V2_KIND_TDTG,
+  ID3V2_KIND_TENC,
+  ID3V2_KIND_TEXT,
+  ID3V2_KIND_TFLT,
+  ID3V2_KIND_TGID,
+  ID3V2_KIND_TIME,
+  ID3V2_KIND_TIPL,
+  ID3V2_KIND_TIT1,
+  ID3V2_KIND_TIT2,
+  ID3V2_KIND_TIT3,
+  ID3V2_KIND_TKEY,
+  ID3V2_KIND_TKWD,
+  ID3V2_KIND_TLAN,
+  ID3V2_KIND_TLEN,
+  ID3V2_KIND_TMCL,
+  ID3V2_KIND_TMED,
+  ID3V2_KIND_TMOO,
+  ID3V2_KIND_TOAL,
+  ID3V2_KIND_TOFN,
+  ID3V2_KIND_TOLY,
+  ID3V2_KIND_TOPE,
+  ID3V2_KIND_TORY,
+  ID3V2_KIND_TOWN,
+  ID3V2_KIND_TPE1,
+  ID3V2_KIND_TPE2,
+  ID3V2_KIND_TPE3,
+  ID3V2_KIND_TPE4,
+  ID3V2_KIND_TPOS,
+  ID3V2_KIND_TPRO,
+  ID3V2_KIND_TPUB,
+  ID3V2_KIND_TRCK,
+  ID3V2_KIND_TRDA,
+  ID3V2_KIND_TRSN,
+  ID3V2_KIND_TRSO,
+  ID3V2_KIND_TSIZ,
+  ID3V2_KIND_TSO2,
+  ID3V2_KIND_TSOA,
+  ID3V2_KIND_TSOC,
+  ID3V2_KIND_TSOP,
+  ID3V2_KIND_TSOT,
+  ID3V2_KIND_TSRC,
+  ID3V2_KIND_TSSE,
+  ID3V2_KIND_TSST,
+  ID3V2_KIND_TXXX,
+  ID3V2_KIND_TYER,
+  ID3V2_KIND_UFID,
+  ID3V2_KIND_USER,
+  ID3V2_KIND_USLT,
+  ID3V2_KIND_WCOM,
+  ID3V2_KIND_WCOP,
+  ID3V2_KIND_WFED,
+  ID3V2_KIND_WOAF,
+  ID3V2_KIND_WOAR,
+  ID3V2_KIND_WOAS,
+  ID3V2_KIND_WORS,
+  ID3V2_KIND_WPAY,
+  ID3V2_KIND_WPUB,
+  ID3V2_KIND_WXXX,
+  ID3V2_KIND_COUNT
+};
+// END FRAME KINDS
+
 /**
  * FRAME IDs
  */
@@ -79,10 +207,14 @@
 #define ID3V2_JPG_MIME_TYPE2 "jpg"
 #define ID3V2_PNG_MIME_TYPE "image/png\0"
 #define ID3V2_PNG_MIME_TYPE2 "png"
+#define ID3V2_GIF_MIME_TYPE "image/gif\0"
+#define ID3V2_BMP_MIME_TYPE "image/bmp\0"
+#define ID3V2_WEBP_MIME_TYPE "image/webp\0"
 #define ID3V2_GET_JPG_MIME_TYPE_FROM_FRAME(x) ID3V2_DECIDE_FRAME(x->version, ID3V2_JPG_MIME_TYPE2, ID3V2_JPG_MIME_TYPE)
 #define ID3V2_GET_PNG_MIME_TYPE_FROM_FRAME(x) ID3V2_DECIDE_FRAME(x->version, ID3V2_PNG_MIME_TYPE2, ID3V2_PNG_MIME_TYPE)
 
 // Picture types:
+#define ID3V2_ANY_PICTURE_TYPE -1 // only used for lookups, matches every picture
 #define ID3V2_OTHER 0x00
 #define ID3V2_FILE_ICON 0x01
 #define ID3V2_OTHER_FILE_ICON 0x02
@@ -104,6 +236,41 @@
 #define ID3V2_ILLUSTRATION 0x12
 #define ID3V2_ARTIST_LOGOTYPE 0x13
 #define ID3V2_PUBLISHER_LOGOTYPE 0x14
+
+// Picture formats:
+#define ID3V2_PICTURE_FORMAT_UNKNOWN 0
+#define ID3V2_PICTURE_FORMAT_JPEG 1
+#define ID3V2_PICTURE_FORMAT_PNG 2
+#define ID3V2_PICTURE_FORMAT_GIF 3
+#define ID3V2_PICTURE_FORMAT_BMP 4
+#define ID3V2_PICTURE_FORMAT_WEBP 5
 // END APIC FRAME CONSTANTS
 
+/**
+ * COLUMN EXPORT CONSTANTS
+ */
+#define ID3V2_STRING_COLUMN 1 // UTF-8 strings, empty if the frame is missing
+#define ID3V2_INTEGER_COLUMN 2 // leading number of the text, 0 if the frame is missing
+#define ID3V2_DICTIONARY_COLUMN 3 // UTF-8 strings stored once, -1 if the frame is missing
+// END COLUMN EXPORT CONSTANTS
+
+/**
+ * TRACE CONSTANTS
+ */
+#define ID3V2_TRACE_LOAD_START 1
+#define ID3V2_TRACE_LOAD_END 2
+#define ID3V2_TRACE_HEADER 3 // a tag header was found
+#define ID3V2_TRACE_FRAME 4
+#define ID3V2_TRACE_UNSYNCHRONISATION 5
+#define ID3V2_TRACE_READ 6
+// END TRACE CONSTANTS
+
+/**
+ * PATCH CONSTANTS
+ */
+#define ID3V2_PATCH_REMOVE 1
+#define ID3V2_PATCH_MODIFY 2 // the data and flags of the frame get replaced
+#define ID3V2_PATCH_ADD 3 // the frame gets appended
+// END PATCH CONSTANTS
+
 #endif
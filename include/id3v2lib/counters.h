@@ -0,0 +1,18 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_counters_h
+#define id3v2lib_counters_h
+
+#include <stdint.h>
+
+int id3v2_update_counter_in_fd(int fd, const char *frame_id, const char *email, int rating, uint64_t value);
+int id3v2_update_counter_in_file(const char *path, const char *frame_id, const char *email, int rating, uint64_t value);
+
+#endif
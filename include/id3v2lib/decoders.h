@@ -0,0 +1,35 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_decoders_h
+#define id3v2lib_decoders_h
+
+#include "types.h"
+#include "constants.h"
+
+int _get_unique_key_of_frame(id3v2_frame *frame, char **key, int *key_size);
+void _read_text_view(char **cursor, char *end, char encoding, id3v2_text_view *view);
+
+// the returned contents belong to the frame and point into its data,
+// they stay valid until the data of the frame gets replaced or the frame freed
+void id3v2_free_contents_of_frame(id3v2_frame *frame);
+id3v2_event_timing_content *id3v2_get_event_timing_content_from_frame(id3v2_frame *frame);
+id3v2_general_object_content *id3v2_get_general_object_content_from_frame(id3v2_frame *frame);
+id3v2_lyrics_content *id3v2_get_lyrics_content_from_frame(id3v2_frame *frame);
+id3v2_music_cd_identifier_content *id3v2_get_music_cd_identifier_content_from_frame(id3v2_frame *frame);
+id3v2_play_counter_content *id3v2_get_play_counter_content_from_frame(id3v2_frame *frame);
+id3v2_popularimeter_content *id3v2_get_popularimeter_content_from_frame(id3v2_frame *frame);
+id3v2_private_content *id3v2_get_private_content_from_frame(id3v2_frame *frame);
+id3v2_relative_volume_content *id3v2_get_relative_volume_content_from_frame(id3v2_frame *frame);
+id3v2_synchronised_lyrics_content *id3v2_get_synchronised_lyrics_content_from_frame(id3v2_frame *frame);
+id3v2_unique_file_identifier_content *id3v2_get_unique_file_identifier_content_from_frame(id3v2_frame *frame);
+id3v2_url_content *id3v2_get_url_content_from_frame(id3v2_frame *frame);
+id3v2_user_text_content *id3v2_get_user_text_content_from_frame(id3v2_frame *frame);
+
+#endif
@@ -25,7 +25,8 @@ enum
   ID3V2_ERROR_INSUFFICIENT_DATA,
   ID3V2_ERROR_UNSUPPORTED,
   ID3V2_ERROR_WRONG_ENCODING,
-  ID3V2_ERROR_UNKNOWN_MIME_TYPE
+  ID3V2_ERROR_UNKNOWN_MIME_TYPE,
+  ID3V2_ERROR_IO
 };
 
 // some helper macros
@@ -0,0 +1,24 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_export_h
+#define id3v2lib_export_h
+
+#include <stdio.h>
+
+#include "types.h"
+
+id3v2_column_exporter *id3v2_new_column_exporter();
+void id3v2_free_column_exporter(id3v2_column_exporter *exporter);
+int id3v2_add_column_to_column_exporter(id3v2_column_exporter *exporter, const char *name, const char *frame_id, int type);
+int id3v2_add_tag_to_column_exporter(id3v2_column_exporter *exporter, id3v2_tag *tag);
+int id3v2_get_row_count_from_column_exporter(id3v2_column_exporter *exporter);
+int id3v2_write_column_exporter_to_file(id3v2_column_exporter *exporter, FILE *file);
+
+#endif
@@ -13,8 +13,12 @@
 #include "types.h"
 #include "constants.h"
 
+void _detach_frame_from_tag(id3v2_tag *tag, id3v2_frame *frame);
 void _free_frame(id3v2_frame *frame);
-id3v2_frame* _parse_frame_from_tag(id3v2_tag *tag, char *bytes);
+int _own_frame_data(id3v2_frame *frame);
+void _release_frame_data(id3v2_frame *frame);
+id3v2_frame* _parse_frame_from_tag(id3v2_tag *tag, char *bytes, int length);
+int _synchronize_buffer(char *data, int size, char *pending_ff);
 void _synchronize_frame(id3v2_frame *frame);
 void id3v2_add_frame_to_tag(id3v2_tag *tag, id3v2_frame *frame);
 id3v2_frame *id3v2_get_frame_from_tag(id3v2_tag *tag, char *frame_id);
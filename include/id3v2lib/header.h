@@ -11,15 +11,23 @@
 #define id3v2lib_header_h
 
 #include <stdio.h>
+#include <stdint.h>
 
 #include "types.h"
 #include "constants.h"
 #include "utils.h"
 
-void _find_header_offsets_in_buffer(char *buffer, int length, int **location, int *size);
-void _find_header_offsets_in_file(FILE *file, int **location, int *size);
-id3v2_header* _get_header_from_buffer(char* buffer, int length);
-id3v2_header* _get_header_from_file(FILE *file, int offset);
+int _add_header_offset(int64_t **offsets, int *size, int64_t offset);
+void _find_header_offsets_in_buffer(char *buffer, size_t length, int64_t **location, int *size);
+void _find_header_offsets_in_file(FILE *file, int64_t **location, int *size);
+void _scan_header_offsets_in_buffer(char *buffer, size_t length, int64_t **location, int *size);
+void _scan_header_offsets_in_file(FILE *file, int64_t **location, int *size);
+void _scan_header_offsets_in_io(id3v2_io *io, int64_t start, int64_t end, int64_t **location, int *size);
+void _locate_header_offsets(id3v2_io *io, int64_t length, int64_t **location, int *size);
+id3v2_header* _get_header_from_buffer(char* buffer, size_t length);
+id3v2_header* _get_header_from_file(FILE *file, int64_t offset);
+id3v2_header* _get_header_from_io(id3v2_io *io, int64_t offset);
+int _get_tag_size_from_footer(char *footer);
 int _identify_id3v2tag(char byte);
 int _has_buffer_id3v2tag(char* raw_header);
 int _has_header_id3v2tag(id3v2_header* tag_header);
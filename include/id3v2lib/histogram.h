@@ -0,0 +1,20 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_histogram_h
+#define id3v2lib_histogram_h
+
+#include "types.h"
+
+void _add_tag_size_to_read_histogram(id3v2_read_histogram *histogram, int size);
+id3v2_read_histogram *id3v2_new_read_histogram();
+void id3v2_free_read_histogram(id3v2_read_histogram *histogram);
+int id3v2_get_first_read_size_from_read_histogram(id3v2_read_histogram *histogram);
+
+#endif
@@ -0,0 +1,22 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_id3v1_h
+#define id3v2lib_id3v1_h
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "types.h"
+
+id3v2_tag *id3v2_load_best_tag_from_file(FILE *file);
+id3v2_tag *id3v2_load_v1_tag_from_buffer(char *buffer, size_t length);
+id3v2_tag *id3v2_load_v1_tag_from_file(FILE *file);
+
+#endif
@@ -0,0 +1,25 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_images_h
+#define id3v2lib_images_h
+
+#include <stdint.h>
+
+#include "types.h"
+
+int _cache_picture_of_frame(id3v2_image_cache *cache, id3v2_frame *frame);
+void _get_picture_from_cached_image(id3v2_cached_image *image, char **picture, int *size);
+void _release_cached_image(id3v2_cached_image *image);
+id3v2_image_cache *id3v2_new_image_cache();
+void id3v2_free_image_cache(id3v2_image_cache *cache);
+int id3v2_get_image_count_from_image_cache(id3v2_image_cache *cache);
+uint64_t id3v2_get_picture_digest_from_frame(id3v2_frame *frame);
+
+#endif
@@ -0,0 +1,22 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_index_h
+#define id3v2lib_index_h
+
+#include "types.h"
+
+// keys are UTF-8 strings compared byte by byte, whatever encoding the frame uses
+void _free_frame_index_of_tag(id3v2_tag *tag);
+id3v2_frame *id3v2_get_private_frame_from_tag(id3v2_tag *tag, const char *owner);
+id3v2_frame *id3v2_get_unique_file_identifier_frame_from_tag(id3v2_tag *tag, const char *owner);
+id3v2_frame *id3v2_get_user_text_frame_from_tag(id3v2_tag *tag, const char *description);
+id3v2_frame *id3v2_get_user_url_frame_from_tag(id3v2_tag *tag, const char *description);
+
+#endif
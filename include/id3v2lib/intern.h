@@ -0,0 +1,22 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_intern_h
+#define id3v2lib_intern_h
+
+#include "types.h"
+
+int _intern_frame_data(id3v2_intern_pool *pool, id3v2_frame *frame);
+id3v2_intern_pool *id3v2_new_intern_pool();
+void id3v2_free_intern_pool(id3v2_intern_pool *pool);
+const char *id3v2_intern_buffer_in_pool(id3v2_intern_pool *pool, const char *buffer, int size);
+int id3v2_get_entry_count_from_intern_pool(id3v2_intern_pool *pool);
+const char *id3v2_get_interned_data_from_frame(id3v2_frame *frame);
+
+#endif
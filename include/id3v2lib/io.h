@@ -0,0 +1,32 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_io_h
+#define id3v2lib_io_h
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "types.h"
+
+typedef struct
+{
+  char *buffer;
+  size_t length;
+} io_buffer;
+
+void _initialize_io_from_buffer(id3v2_io *io, io_buffer *buffer);
+int _read_from_io(id3v2_io *io, int64_t offset, char *buffer, int size);
+int64_t _get_size_of_io(id3v2_io *io);
+void _hint_io(id3v2_io *io, int64_t offset, int64_t size);
+void id3v2_initialize_io_from_file(id3v2_io *io, FILE *file);
+void id3v2_initialize_io_from_fd(id3v2_io *io, int fd);
+
+#endif
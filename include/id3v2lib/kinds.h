@@ -0,0 +1,21 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_kinds_h
+#define id3v2lib_kinds_h
+
+#include "types.h"
+#include "constants.h"
+
+int _is_valid_frame_id(const char *id, int version);
+int _get_frame_kind_from_id(const char *id, int version);
+int _get_frame_type_from_id(const char *id, int version);
+int id3v2_get_frame_kind(id3v2_frame *frame);
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_patch_h
+#define id3v2lib_patch_h
+
+#include "types.h"
+
+int id3v2_apply_patch_to_tag(id3v2_tag *tag, id3v2_patch *patch);
+id3v2_patch *id3v2_diff_tags(id3v2_tag *old_tag, id3v2_tag *new_tag);
+void id3v2_free_patch(id3v2_patch *patch);
+
+#endif
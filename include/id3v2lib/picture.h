@@ -0,0 +1,22 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_picture_h
+#define id3v2lib_picture_h
+
+#include <stdio.h>
+
+#include "types.h"
+
+int _get_picture_format_from_buffer(const char *data, int size);
+int id3v2_extract_picture_to_fd(FILE *file, int picture_type, int fd);
+void id3v2_probe_picture_in_buffer(const char *data, int size, id3v2_picture_info *info);
+void id3v2_probe_picture_in_frame(id3v2_frame *frame, id3v2_picture_info *info);
+
+#endif
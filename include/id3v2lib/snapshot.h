@@ -0,0 +1,29 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_snapshot_h
+#define id3v2lib_snapshot_h
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "types.h"
+
+int id3v2_write_snapshot_to_file(id3v2_tag **tags, int count, FILE *file);
+char *id3v2_write_snapshot_to_buffer(id3v2_tag **tags, int count, size_t *size);
+id3v2_snapshot *id3v2_map_snapshot_from_buffer(const char *buffer, size_t length);
+id3v2_snapshot *id3v2_map_snapshot_from_file(const char *path);
+void id3v2_unmap_snapshot(id3v2_snapshot *snapshot);
+int id3v2_get_tag_count_from_snapshot(id3v2_snapshot *snapshot);
+int id3v2_get_frame_count_from_snapshot(id3v2_snapshot *snapshot, int tag_index);
+int id3v2_get_header_from_snapshot(id3v2_snapshot *snapshot, int tag_index, id3v2_header *header);
+int id3v2_get_frame_from_snapshot(id3v2_snapshot *snapshot, int tag_index, int frame_index, id3v2_frame *frame);
+int id3v2_find_frame_in_snapshot(id3v2_snapshot *snapshot, int tag_index, char *frame_id, id3v2_frame *frame);
+
+#endif
@@ -0,0 +1,39 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_stats_h
+#define id3v2lib_stats_h
+
+#include <stddef.h>
+
+#include "types.h"
+
+extern volatile int id3v2_stats_enabled;
+
+id3v2_stats *_get_stats_of_thread();
+void _add_stats(id3v2_stats *stats, const id3v2_stats *other);
+void *_allocate(size_t size);
+void *_allocate_zeroed(size_t count, size_t size);
+void *_reallocate(void *pointer, size_t size);
+void id3v2_enable_stats(int enabled);
+void id3v2_get_stats(id3v2_stats *stats);
+void id3v2_reset_stats();
+
+// helper macros for the counters, building with ID3V2_NO_STATS compiles them out
+#ifdef ID3V2_NO_STATS
+#define STATS_ADD(field, value) ((void)0)
+#define STATS_START_TIMER(start) ((start) = 0)
+#define STATS_STOP_TIMER(field, start) ((void)(start))
+#else
+#define STATS_ADD(field, value) do { if(id3v2_stats_enabled) _get_stats_of_thread()->field += (value); } while(0)
+#define STATS_START_TIMER(start) ((start) = id3v2_stats_enabled ? _get_monotonic_nanoseconds() : 0)
+#define STATS_STOP_TIMER(field, start) do { if((start) != 0) _get_stats_of_thread()->field += _get_monotonic_nanoseconds() - (start); } while(0)
+#endif
+
+#endif
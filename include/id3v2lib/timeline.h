@@ -0,0 +1,20 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_timeline_h
+#define id3v2lib_timeline_h
+
+#include "types.h"
+
+int _sort_timeline(id3v2_timeline *timeline, char *values, int value_size);
+int id3v2_get_entry_at_time_from_timeline(id3v2_timeline *timeline, uint32_t time);
+void id3v2_initialize_timeline_cursor(id3v2_timeline_cursor *cursor, id3v2_timeline *timeline);
+int id3v2_move_timeline_cursor_to_time(id3v2_timeline_cursor *cursor, uint32_t time);
+
+#endif
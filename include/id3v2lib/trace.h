@@ -0,0 +1,62 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_trace_h
+#define id3v2lib_trace_h
+
+#include <stdint.h>
+
+#include "types.h"
+#include "constants.h"
+
+// every probe gets a semaphore, which the tracing tools raise while they are attached to it
+#ifdef ID3V2_USDT
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+extern unsigned short id3v2lib_load_start_semaphore;
+extern unsigned short id3v2lib_load_end_semaphore;
+extern unsigned short id3v2lib_read_semaphore;
+extern unsigned short id3v2lib_header_semaphore;
+extern unsigned short id3v2lib_frame_semaphore;
+extern unsigned short id3v2lib_unsynchronisation_semaphore;
+#endif
+
+extern id3v2_trace_callback id3v2_trace_function;
+
+void _trace(int type, int64_t offset, int64_t size, int64_t result, const char *frame_id, int flags, int64_t nanoseconds);
+const char *_terminate_trace_frame_id(const char *frame_id, char *copy);
+void id3v2_set_trace_callback(id3v2_trace_callback callback, void *context);
+
+// tells whether anyone listens to the probe id3v2lib:name, so the trace points only measure time when it gets reported
+#ifdef ID3V2_USDT
+#define TRACE_ENABLED(name) (id3v2lib_##name##_semaphore != 0 || id3v2_trace_function != NULL)
+#else
+#define TRACE_ENABLED(name) (id3v2_trace_function != NULL)
+#endif
+
+// fires the probe id3v2lib:name for tools like bpftrace and hands the event to the callback if one is set,
+// the arguments only get evaluated if one of them listens
+// frame ids aren't null terminated, so the probe gets a terminated copy the tools can read as a string
+#ifdef ID3V2_USDT
+#define TRACE(name, type, offset, size, result, frame_id, flags, nanoseconds) do { \
+    if(TRACE_ENABLED(name)) { \
+      char _trace_frame_id[ID3V2_FRAME_ID + 1]; \
+      DTRACE_PROBE6(id3v2lib, name, (int64_t)(offset), (int64_t)(size), (int64_t)(result), \
+                    _terminate_trace_frame_id(frame_id, _trace_frame_id), (int)(flags), (int64_t)(nanoseconds)); \
+      if(id3v2_trace_function != NULL) _trace(type, offset, size, result, frame_id, flags, nanoseconds); \
+    } \
+  } while(0)
+#else
+#define TRACE(name, type, offset, size, result, frame_id, flags, nanoseconds) do { \
+    if(id3v2_trace_function != NULL) _trace(type, offset, size, result, frame_id, flags, nanoseconds); \
+  } while(0)
+#endif
+
+#endif
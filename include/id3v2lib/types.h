@@ -10,10 +10,22 @@
 #ifndef id3v2lib_types_h
 #define id3v2lib_types_h
 
+#include <stdint.h>
+
 #include "constants.h"
 
 typedef struct id3v2_frame id3v2_frame;
 typedef struct id3v2_tag id3v2_tag;
+typedef struct id3v2_intern_pool id3v2_intern_pool;
+typedef struct id3v2_image_cache id3v2_image_cache;
+typedef struct id3v2_read_histogram id3v2_read_histogram;
+typedef struct id3v2_tag_cache id3v2_tag_cache;
+typedef struct id3v2_snapshot id3v2_snapshot;
+typedef struct id3v2_column_exporter id3v2_column_exporter;
+typedef struct id3v2_cached_image id3v2_cached_image;
+typedef struct id3v2_decoded_frame id3v2_decoded_frame;
+typedef struct id3v2_frame_index id3v2_frame_index;
+typedef struct id3v2_chapter_index id3v2_chapter_index;
 
 typedef struct
 {
@@ -34,6 +46,9 @@ struct id3v2_frame
     char* data;
     id3v2_frame *next;
     char parsed; // indicates if the frame could be successfully parsed or not
+    char interned; // data is owned by an intern pool and must neither be freed nor modified
+    id3v2_cached_image *image; // shared picture payload of APIC frames, data and size only cover the bytes in front of it then
+    id3v2_decoded_frame *decoded; // fields found by the typed getters on their first call, NULL before
     id3v2_tag *tag;
 };
 
@@ -43,11 +58,265 @@ struct id3v2_tag
     id3v2_frame *frame;
     void **allocations;
     int allocation_count;
+    id3v2_frame_index *index; // TXXX, WXXX, PRIV and UFID frames by their key, built by the first keyed lookup
+    id3v2_chapter_index *chapters; // CHAP frames sorted by time along with the CTOC frames, built by the first chapter lookup
 };
 
+typedef struct
+{
+    int format; // one of the ID3V2_PICTURE_FORMAT_* constants
+    int width;
+    int height;
+    int depth; // bits per pixel, 0 if the format doesn't tell
+} id3v2_picture_info;
+
+// a string inside the data of a frame, neither copied nor null terminated
+typedef struct
+{
+    char *text; // BOM included
+    int size; // without the terminator
+    char encoding; // one of the ID3V2_*_ENCODING constants
+} id3v2_text_view;
+
+// TXXX and WXXX, the value of WXXX is always ISO-8859-1
+typedef struct
+{
+    id3v2_text_view description;
+    id3v2_text_view value;
+} id3v2_user_text_content;
+
+// every W frame but WXXX
+typedef struct
+{
+    id3v2_text_view url;
+} id3v2_url_content;
+
+// USLT and COMM
+typedef struct
+{
+    char *language; // 3 characters
+    id3v2_text_view description;
+    id3v2_text_view text;
+} id3v2_lyrics_content;
+
+// time stamps of a SYLT or ETCO frame sorted from the earliest on, frames keeping
+// them unsorted get their entries sorted, those with equal time stamps stay in order
+typedef struct
+{
+    uint32_t *timestamps;
+    int count;
+} id3v2_timeline;
+
+// follows the playback through a timeline
+typedef struct
+{
+    id3v2_timeline *timeline;
+    int entry; // the entry playing at the last time it moved to, -1 before the first one
+} id3v2_timeline_cursor;
+
+// SYLT
+typedef struct
+{
+    char *language; // 3 characters
+    int timestamp_format; // 1 for MPEG frames, 2 for milliseconds
+    int content_type;
+    id3v2_text_view description;
+    char *data; // text and time stamp pairs
+    int size;
+    id3v2_timeline timeline;
+    id3v2_text_view *lines; // the text of each entry of the timeline
+} id3v2_synchronised_lyrics_content;
+
+// ETCO
+typedef struct
+{
+    int timestamp_format; // 1 for MPEG frames, 2 for milliseconds
+    id3v2_timeline timeline;
+    unsigned char *events; // the type of each entry of the timeline
+} id3v2_event_timing_content;
+
+// POPM
+typedef struct
+{
+    id3v2_text_view email;
+    int rating; // 1 to 255, 0 if unknown
+    uint64_t counter; // 0 if the frame has none
+} id3v2_popularimeter_content;
+
+// PCNT
+typedef struct
+{
+    uint64_t counter;
+} id3v2_play_counter_content;
+
+// UFID
+typedef struct
+{
+    id3v2_text_view owner;
+    char *identifier;
+    int size;
+} id3v2_unique_file_identifier_content;
+
+// PRIV
+typedef struct
+{
+    id3v2_text_view owner;
+    char *data;
+    int size;
+} id3v2_private_content;
+
+// GEOB
+typedef struct
+{
+    id3v2_text_view mime_type;
+    id3v2_text_view filename;
+    id3v2_text_view description;
+    char *object;
+    int size;
+} id3v2_general_object_content;
+
+// MCDI
+typedef struct
+{
+    char *table_of_contents; // as found on the CD
+    int size;
+} id3v2_music_cd_identifier_content;
+
+typedef struct
+{
+    int type; // 0 for other, 1 for master volume, 2 for front right and so on
+    int adjustment; // in 1/512 dB
+    int peak_bits;
+    char *peak; // peak_bits rounded up to full bytes, big endian
+} id3v2_volume_channel;
+
+// RVA2
+typedef struct
+{
+    id3v2_text_view identification;
+    int channel_count;
+    id3v2_volume_channel channels[ID3V2_VOLUME_CHANNELS];
+} id3v2_relative_volume_content;
+
+// CHAP, valid until the frames of its tag change
+typedef struct
+{
+    id3v2_text_view element_id;
+    uint32_t start_time; // in milliseconds
+    uint32_t end_time; // in milliseconds, the chapter ends right before it
+    uint32_t start_offset; // in bytes from the start of the file, 0xFFFFFFFF if unused
+    uint32_t end_offset;
+    id3v2_frame *frame;
+    char *embedded_frames; // TIT2, APIC and the like describing the chapter
+    int embedded_size;
+    id3v2_tag *embedded_tag; // the embedded frames, parsed by the first id3v2_get_tag_from_chapter() call
+} id3v2_chapter;
+
+// CTOC, valid until the frames of its tag change
+typedef struct
+{
+    id3v2_text_view element_id;
+    char top_level;
+    char ordered;
+    int entry_count;
+    char *entries; // element IDs of chapters and other tables, each null terminated
+    int entries_size;
+    id3v2_frame *frame;
+    char *embedded_frames;
+    int embedded_size;
+    id3v2_tag *embedded_tag; // parsed by the first id3v2_get_tag_from_table_of_contents() call
+} id3v2_table_of_contents;
+
+// storage the loaders read from, so tags can be read from anything which supports ranged reads
+typedef struct
+{
+    void *context; // handed to every callback
+    int (*read_at)(void *context, int64_t offset, char *buffer, int size); // returns the amount of bytes read
+    int64_t (*size)(void *context); // returns the total size or -1 if it is unknown
+    void (*hint)(void *context, int64_t offset, int64_t size); // announces the range read next, may be NULL
+} id3v2_io;
+
+typedef struct
+{
+    id3v2_intern_pool *intern_pool; // text frame contents get deduplicated into this pool, may be NULL
+    id3v2_image_cache *image_cache; // APIC pictures get stored once in this cache, may be NULL
+    char deep_scan; // search every byte for tags instead of following the sizes from the start and the footers from the end
+    int64_t offset_hint; // where the tag is expected by the single tag loaders, -1 if unknown
+    id3v2_read_histogram *read_histogram; // sizes the first read from the tags seen so far, may be NULL
+} id3v2_load_options;
+
+typedef struct
+{
+    id3v2_tag *tag; // the first tag of the file, NULL if there is none
+    unsigned short error; // what id3v2_get_error() would have returned after loading the file on its own
+} id3v2_batch_result;
+
+typedef struct
+{
+    int64_t hits; // loads answered from the cache
+    int64_t misses; // loads which had to read the audio file
+    int64_t hit_nanoseconds; // time spent on hits
+    int64_t miss_nanoseconds; // time spent on misses, storing the result included
+} id3v2_tag_cache_statistics;
+
+// what the loads of a thread did since its stats got reset, the timers are only read while stats are enabled
+// batch loads count towards the thread which started the batch, whichever threads did the work
+typedef struct
+{
+    int64_t bytes_scanned; // read while looking for tag headers
+    int64_t headers_parsed;
+    int64_t frames_parsed;
+    int64_t frames_unparsed; // found, but dropped since they couldn't be parsed
+    int64_t unsynchronisation_bytes_removed;
+    int64_t allocations; // reallocations included
+    int64_t bytes_allocated;
+    int64_t scan_nanoseconds; // looking for tag headers
+    int64_t frame_nanoseconds; // parsing frames, reversing their unsynchronisation included
+    int64_t unsynchronisation_nanoseconds;
+} id3v2_stats;
+
+// one trace point passed by a load, fields which don't apply to the type are -1 or NULL
+typedef struct
+{
+    int type; // one of the ID3V2_TRACE_* constants
+    int64_t offset; // position of a found header or a read in the file, of a frame behind the tag header
+    int64_t size; // bytes asked for by a read, size of a frame or loaded tag, bytes before the unsynchronisation was reversed
+    int64_t result; // bytes returned by a read, 1 if a frame got parsed, bytes after the unsynchronisation was reversed, error of a finished load
+    const char *frame_id; // not null terminated, 3 or 4 characters depending on the version
+    int flags; // both frame flag bytes, the first one in the high byte
+    int64_t nanoseconds; // duration of reads and finished loads
+} id3v2_trace_event;
+
+typedef void (*id3v2_trace_callback)(const id3v2_trace_event *event, void *context);
+
+// one change to the frames of a tag, frames are told apart by their ID, their key and their occurrence
+// the key holds what the standard keeps unique among frames with the same ID: the language and description of
+// COMM, USLT and SYLT, the description of TXXX, WXXX and GEOB, the owner of PRIV and UFID, the email of POPM,
+// the picture type and description of APIC, all converted to UTF-8. Other frames have an empty key.
+typedef struct
+{
+    int type; // one of the ID3V2_PATCH_* constants
+    char id[ID3V2_FRAME_ID];
+    char *key;
+    int key_size;
+    int occurrence; // 0 for the first frame with the ID and key, in the order of the tag the patch applies to
+    char flags[ID3V2_FRAME_FLAGS];
+    char *data; // the new data, NULL for ID3V2_PATCH_REMOVE
+    int size;
+} id3v2_patch_operation;
+
+// removals come first, then modifications, then additions, each in the order of their frames
+typedef struct
+{
+    int version; // frame IDs depend on it, so a patch only applies to tags of the same version
+    id3v2_patch_operation *operations;
+    int count; // 0 if both tags hold the same frames, nothing needs to be written then
+} id3v2_patch;
+
 // Constructor functions
 id3v2_header* _new_header();
 id3v2_frame* id3v2_new_frame(id3v2_tag *tag, int type);
 id3v2_tag* id3v2_new_tag();
+void id3v2_initialize_load_options(id3v2_load_options *options);
 
 #endif
@@ -10,6 +10,9 @@
 #ifndef id3v2lib_utils_h
 #define id3v2lib_utils_h
 
+#include <stdio.h>
+#include <stdint.h>
+
 #include "types.h"
 
 const char * _get_mime_type_from_buffer(char *data, int size);
@@ -17,9 +20,34 @@ unsigned int btoi(char* bytes, int size, int offset);
 char* itob(int integer);
 int syncint_encode(int value);
 int syncint_decode(int value);
+void _write_little_endian_to_buffer(char *buffer, uint64_t value, int size);
+uint64_t _read_little_endian_from_buffer(const char *buffer, int size);
+uint64_t _xxhash64_buffer(const char *buffer, int size, uint64_t seed);
 void id3v2_free_tag(id3v2_tag* tag);
 
 // String functions
 int has_bom(char *string);
+int _convert_text_to_utf8(const char *text, int size, char encoding, char *utf8);
+
+// File functions, offsets are 64 bit on every platform
+int _seek_in_file(FILE *file, int64_t offset, int origin);
+int64_t _get_position_in_file(FILE *file);
+int64_t _get_length_of_file(FILE *file);
+int _read_from_fd(int fd, int64_t offset, char *buffer, int size);
+int64_t _get_length_of_fd(int fd);
+int _write_to_fd(int fd, int64_t offset, const char *buffer, int size);
+
+// Time functions
+int64_t _get_monotonic_nanoseconds();
+
+// Thread functions
+void *_start_thread(void (*routine)(void *argument), void *argument);
+void _join_thread(void *thread);
+
+// Mutex functions
+void *_new_mutex();
+void _lock_mutex(void *mutex);
+void _unlock_mutex(void *mutex);
+void _free_mutex(void *mutex);
 
 #endif
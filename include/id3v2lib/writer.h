@@ -0,0 +1,21 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef id3v2lib_writer_h
+#define id3v2lib_writer_h
+
+#include <stddef.h>
+
+#include "types.h"
+
+int _get_size_of_frame_in_tag(id3v2_frame *frame);
+int _write_frame_to_buffer(id3v2_frame *frame, char *buffer);
+char *id3v2_write_tag_to_buffer(id3v2_tag *tag, size_t *size);
+
+#endif
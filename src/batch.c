@@ -0,0 +1,603 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE // syscall()
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// io_uring gets driven through the raw system calls, so there is no dependency on liburing
+#if defined(__linux__) && !defined(ID3V2_NO_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define BATCH_IO_URING
+#endif
+#endif
+
+#ifdef BATCH_IO_URING
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "id3v2lib.h"
+
+#define BATCH_THREADS 16 // the fallback blocks on every read, so it uses more threads than there are cores
+#define BATCH_PROBE_OPS 64 // enough to cover every request the ring uses
+
+static void _load_batch_entry(const char *path, id3v2_batch_result *result, id3v2_load_options *options)
+{
+  FILE *file = fopen(path, "rb");
+
+  if(file == NULL)
+  {
+    result->tag = NULL;
+    result->error = ID3V2_ERROR_UNABLE_TO_OPEN;
+    return;
+  }
+
+  result->tag = id3v2_load_tag_from_file_with_options(file, options);
+  result->error = E_GET;
+
+  fclose(file);
+}
+
+typedef struct
+{
+  const char **paths;
+  id3v2_batch_result *results;
+  id3v2_load_options *options;
+  int count;
+  int next; // next file nobody took care of yet
+  void *mutex;
+  id3v2_stats stats; // what the threads did, handed to the caller once they are done
+} batch_pool;
+
+static void _run_batch_pool(void *argument)
+{
+  batch_pool *pool = (batch_pool*)argument;
+  int i;
+
+  for(;;)
+  {
+    _lock_mutex(pool->mutex);
+    i = pool->next++;
+    _unlock_mutex(pool->mutex);
+
+    if(i >= pool->count)
+      break;
+
+    _load_batch_entry(pool->paths[i], &pool->results[i], pool->options);
+  }
+
+  _lock_mutex(pool->mutex);
+  _add_stats(&pool->stats, _get_stats_of_thread());
+  _unlock_mutex(pool->mutex);
+}
+
+// loads the files from first on with blocking reads spread over several threads
+static void _load_batch_with_threads(const char **paths, int first, int count, id3v2_batch_result *results, id3v2_load_options *options)
+{
+  batch_pool pool;
+  void *threads[BATCH_THREADS];
+  int thread_count = 0;
+  int i;
+
+  pool.paths = paths;
+  pool.results = results;
+  pool.options = options;
+  pool.count = count;
+  pool.next = first;
+  pool.mutex = _new_mutex();
+  memset(&pool.stats, 0, sizeof(id3v2_stats));
+
+  if(pool.mutex != NULL)
+  {
+    for(i = 0; i < BATCH_THREADS && i < count - first; i++)
+    {
+      threads[thread_count] = _start_thread(_run_batch_pool, &pool);
+      if(threads[thread_count] == NULL)
+        break;
+      thread_count++;
+    }
+  }
+
+  // without threads the caller's thread does all the work
+  if(thread_count == 0)
+  {
+    for(i = first; i < count; i++)
+      _load_batch_entry(paths[i], &results[i], options);
+  }
+
+  for(i = 0; i < thread_count; i++)
+    _join_thread(threads[i]);
+
+  _add_stats(_get_stats_of_thread(), &pool.stats);
+  _free_mutex(pool.mutex);
+}
+
+#ifdef BATCH_IO_URING
+
+enum
+{
+  BATCH_OPEN,
+  BATCH_READ,
+  BATCH_READ_REST,
+  BATCH_CLOSE
+};
+
+typedef struct
+{
+  int index; // the file this slot takes care of, -1 if the slot is free
+  int stage;
+  int fd;
+  char *buffer;
+  int buffer_size;
+  int read_size;
+} batch_slot;
+
+typedef struct
+{
+  int fd;
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  void *sq_ring;
+  size_t sq_ring_size;
+  void *cq_ring;
+  size_t cq_ring_size;
+  size_t sqes_size;
+  unsigned pending; // queued entries the kernel didn't see yet
+  unsigned in_flight; // entries the kernel took, but didn't complete yet
+} batch_ring;
+
+static void _close_batch_ring(batch_ring *ring)
+{
+  if(ring->sqes != NULL)
+    munmap(ring->sqes, ring->sqes_size);
+  if(ring->cq_ring != NULL && ring->cq_ring != ring->sq_ring)
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  if(ring->sq_ring != NULL)
+    munmap(ring->sq_ring, ring->sq_ring_size);
+  close(ring->fd);
+}
+
+// asks the kernel whether the ring can open, read and close files
+static int _has_batch_ring_requests(batch_ring *ring)
+{
+  static const int requests[] = { IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE };
+  struct io_uring_probe *probe;
+  int supported = 1;
+  int i;
+
+  probe = (struct io_uring_probe*)_allocate_zeroed(1, sizeof(struct io_uring_probe) + BATCH_PROBE_OPS * sizeof(struct io_uring_probe_op));
+
+  if(probe == NULL)
+    return 0;
+
+  if(syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, BATCH_PROBE_OPS) < 0)
+    supported = 0;
+
+  for(i = 0; supported && i < (int)(sizeof(requests) / sizeof(requests[0])); i++)
+    supported = (probe->ops[requests[i]].flags & IO_URING_OP_SUPPORTED) != 0; // ops_len isn't filled in everywhere
+
+  free(probe);
+
+  return supported;
+}
+
+// returns 0 if the kernel doesn't offer io_uring, or doesn't allow it to be used
+static int _open_batch_ring(batch_ring *ring, unsigned entries)
+{
+  struct io_uring_params params;
+  char *sq_ring;
+  char *cq_ring;
+
+  memset(ring, 0, sizeof(batch_ring));
+  memset(&params, 0, sizeof(params));
+
+  ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+
+  if(ring->fd < 0)
+    return 0;
+
+  ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+  // newer kernels map both rings at once
+  if(params.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    if(ring->cq_ring_size > ring->sq_ring_size)
+      ring->sq_ring_size = ring->cq_ring_size;
+    ring->cq_ring_size = ring->sq_ring_size;
+  }
+
+  sq_ring = (char*)mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+
+  if(sq_ring == MAP_FAILED)
+  {
+    close(ring->fd);
+    return 0;
+  }
+
+  ring->sq_ring = sq_ring;
+
+  if(params.features & IORING_FEAT_SINGLE_MMAP)
+    cq_ring = sq_ring;
+  else
+  {
+    cq_ring = (char*)mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    if(cq_ring == MAP_FAILED)
+    {
+      ring->cq_ring = NULL;
+      _close_batch_ring(ring);
+      return 0;
+    }
+  }
+
+  ring->cq_ring = cq_ring;
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+  if(ring->sqes == MAP_FAILED)
+  {
+    ring->sqes = NULL;
+    _close_batch_ring(ring);
+    return 0;
+  }
+
+  ring->sq_head = (unsigned*)(sq_ring + params.sq_off.head);
+  ring->sq_tail = (unsigned*)(sq_ring + params.sq_off.tail);
+  ring->sq_mask = (unsigned*)(sq_ring + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned*)(sq_ring + params.sq_off.array);
+  ring->cq_head = (unsigned*)(cq_ring + params.cq_off.head);
+  ring->cq_tail = (unsigned*)(cq_ring + params.cq_off.tail);
+  ring->cq_mask = (unsigned*)(cq_ring + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe*)(cq_ring + params.cq_off.cqes);
+
+  // kernels before 5.6 neither know the probe nor the requests, some only allow part of the requests
+  if(!_has_batch_ring_requests(ring))
+  {
+    _close_batch_ring(ring);
+    return 0;
+  }
+
+  return 1;
+}
+
+// every slot has at most one request in flight, so the submission queue never runs full
+static struct io_uring_sqe *_queue_batch_request(batch_ring *ring, int slot)
+{
+  unsigned tail = *ring->sq_tail;
+  unsigned index = tail & *ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[index];
+
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  sqe->user_data = (unsigned long long)slot;
+  ring->sq_array[index] = index;
+
+  // the entry has to be complete before the kernel may see the new tail
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  ring->pending++;
+
+  return sqe;
+}
+
+static void _queue_batch_open(batch_ring *ring, batch_slot *slots, int slot, const char *path)
+{
+  struct io_uring_sqe *sqe = _queue_batch_request(ring, slot);
+
+  sqe->opcode = IORING_OP_OPENAT;
+  sqe->fd = AT_FDCWD;
+  sqe->addr = (unsigned long long)(uintptr_t)path;
+  sqe->open_flags = O_RDONLY | O_CLOEXEC;
+  slots[slot].stage = BATCH_OPEN;
+}
+
+static void _queue_batch_read(batch_ring *ring, batch_slot *slots, int slot, int stage)
+{
+  struct io_uring_sqe *sqe = _queue_batch_request(ring, slot);
+
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = slots[slot].fd;
+  sqe->addr = (unsigned long long)(uintptr_t)(slots[slot].buffer + slots[slot].read_size);
+  sqe->len = slots[slot].buffer_size - slots[slot].read_size;
+  sqe->off = slots[slot].read_size;
+  slots[slot].stage = stage;
+}
+
+static void _queue_batch_close(batch_ring *ring, batch_slot *slots, int slot)
+{
+  struct io_uring_sqe *sqe = _queue_batch_request(ring, slot);
+
+  sqe->opcode = IORING_OP_CLOSE;
+  sqe->fd = slots[slot].fd;
+  slots[slot].stage = BATCH_CLOSE;
+}
+
+// parses the head of the file as soon as it arrived, returns 1 if the rest of the tag is still missing
+// reads may come back short before the end of the file, only an empty one tells there is nothing more to read
+static int _complete_batch_read(batch_slot *slot, int last_read, id3v2_batch_result *result, id3v2_load_options *options)
+{
+  char *buffer;
+  id3v2_header *header;
+  int tag_size;
+
+  if(slot->read_size < ID3V2_HEADER && last_read > 0)
+    return 1;
+
+  header = _get_header_from_buffer(slot->buffer, slot->read_size);
+
+  if(header == NULL)
+  {
+    // no tag at the start, so look for it at the end, which doesn't happen often enough to queue it
+    result->tag = id3v2_load_tag_from_fd_with_options(slot->fd, options);
+    result->error = E_GET;
+    return 0;
+  }
+
+  tag_size = ID3V2_HEADER + header->tag_size;
+  free(header);
+
+  if(slot->stage == BATCH_READ && options != NULL)
+    _add_tag_size_to_read_histogram(options->read_histogram, tag_size);
+
+  if(tag_size > slot->read_size && last_read > 0)
+  {
+    if(tag_size <= slot->buffer_size)
+      return 1;
+
+    buffer = (char*)_reallocate(slot->buffer, tag_size);
+    if(buffer != NULL)
+    {
+      slot->buffer = buffer;
+      slot->buffer_size = tag_size;
+      return 1;
+    }
+  }
+
+  result->tag = id3v2_load_tag_from_buffer_with_options(slot->buffer, slot->read_size, options);
+  result->error = E_GET;
+
+  return 0;
+}
+
+// called once the ring failed: closes the kernel never got are done right away, and the requests it took are
+// waited for, so the descriptors of opens still in flight end up in their slots instead of getting lost
+static void _drain_batch_ring(batch_ring *ring, batch_slot *slots)
+{
+  struct io_uring_cqe *cqe;
+  unsigned head;
+  unsigned tail;
+  int slot;
+
+  // the results of files whose close is queued are set already
+  for(tail = *ring->sq_tail - ring->pending; tail != *ring->sq_tail; tail++)
+  {
+    slot = (int)ring->sqes[tail & *ring->sq_mask].user_data;
+    if(slots[slot].stage == BATCH_CLOSE)
+    {
+      close(slots[slot].fd);
+      slots[slot].index = -1;
+    }
+  }
+
+  while(ring->in_flight > 0)
+  {
+    head = *ring->cq_head;
+
+    while(head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+    {
+      cqe = &ring->cqes[head & *ring->cq_mask];
+      slot = (int)cqe->user_data;
+      head++;
+      ring->in_flight--;
+
+      if(slots[slot].stage == BATCH_OPEN && cqe->res >= 0)
+        slots[slot].fd = cqe->res;
+      else if(slots[slot].stage == BATCH_CLOSE)
+        slots[slot].index = -1;
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+    // if even waiting fails, nothing can be done about the rest anymore
+    if(ring->in_flight > 0 &&
+       syscall(__NR_io_uring_enter, ring->fd, 0, ring->in_flight, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+      break;
+  }
+}
+
+// returns the amount of files handed to the ring before it failed, count if everything went fine
+// the files still in the slots then have to be finished by _finish_batch_slots() once the ring is closed
+static int _load_batch_with_ring(batch_ring *ring, batch_slot *slots, const char **paths, int count, id3v2_batch_result *results, id3v2_load_options *options)
+{
+  struct io_uring_cqe *cqe;
+  int active = 0;
+  int first_size;
+  unsigned head;
+  int next = 0;
+  int res;
+  int slot;
+
+  while(next < count || active > 0)
+  {
+    // refill the free slots
+    for(slot = 0; slot < ID3V2_BATCH_QUEUE_DEPTH && next < count; slot++)
+    {
+      if(slots[slot].index >= 0)
+        continue;
+      slots[slot].index = next++;
+      slots[slot].fd = -1;
+      _queue_batch_open(ring, slots, slot, paths[slots[slot].index]);
+      active++;
+    }
+
+    res = (int)syscall(__NR_io_uring_enter, ring->fd, ring->pending, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+
+    if(res < 0)
+    {
+      if(errno == EINTR)
+        continue;
+      _drain_batch_ring(ring, slots);
+      return next;
+    }
+
+    // the kernel may take fewer entries than it got offered, the others are offered again next time
+    ring->pending -= res;
+    ring->in_flight += res;
+
+    head = *ring->cq_head;
+
+    while(head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+    {
+      cqe = &ring->cqes[head & *ring->cq_mask];
+      slot = (int)cqe->user_data;
+      res = cqe->res;
+      head++;
+      ring->in_flight--;
+
+      switch(slots[slot].stage)
+      {
+        case BATCH_OPEN:
+          if(res < 0)
+          {
+            results[slots[slot].index].tag = NULL;
+            results[slots[slot].index].error = ID3V2_ERROR_UNABLE_TO_OPEN;
+            slots[slot].index = -1;
+            active--;
+            break;
+          }
+          first_size = id3v2_get_first_read_size_from_read_histogram(options != NULL ? options->read_histogram : NULL);
+          slots[slot].fd = res;
+          slots[slot].buffer = (char*)_allocate(first_size);
+          slots[slot].buffer_size = first_size;
+          slots[slot].read_size = 0;
+          if(slots[slot].buffer == NULL)
+          {
+            results[slots[slot].index].tag = NULL;
+            results[slots[slot].index].error = ID3V2_ERROR_MEMORY_ALLOCATION;
+            _queue_batch_close(ring, slots, slot);
+            break;
+          }
+          memset(slots[slot].buffer, 0, ID3V2_HEADER + ID3V2_EXTENDED_HEADER_SIZE);
+          _queue_batch_read(ring, slots, slot, BATCH_READ);
+          break;
+
+        case BATCH_READ:
+        case BATCH_READ_REST:
+          if(res < 0)
+          {
+            results[slots[slot].index].tag = NULL;
+            results[slots[slot].index].error = ID3V2_ERROR_IO;
+          }
+          else
+          {
+            slots[slot].read_size += res;
+            if(_complete_batch_read(&slots[slot], res, &results[slots[slot].index], options))
+            {
+              _queue_batch_read(ring, slots, slot, slots[slot].read_size < ID3V2_HEADER ? BATCH_READ : BATCH_READ_REST);
+              break;
+            }
+          }
+          free(slots[slot].buffer);
+          slots[slot].buffer = NULL;
+          _queue_batch_close(ring, slots, slot);
+          break;
+
+        case BATCH_CLOSE:
+          slots[slot].index = -1;
+          active--;
+          break;
+      }
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+  }
+
+  return count;
+}
+
+// loads the files the ring didn't finish anew, only after the ring is closed, as requests still in flight
+// may write into the buffers of their slots until then
+static void _finish_batch_slots(batch_slot *slots, const char **paths, id3v2_batch_result *results, id3v2_load_options *options)
+{
+  int slot;
+
+  for(slot = 0; slot < ID3V2_BATCH_QUEUE_DEPTH; slot++)
+  {
+    free(slots[slot].buffer);
+
+    // once the close is queued the result is set, and the descriptor may already belong to someone else
+    if(slots[slot].index < 0 || slots[slot].stage == BATCH_CLOSE)
+      continue;
+
+    if(slots[slot].fd >= 0)
+      close(slots[slot].fd);
+
+    _load_batch_entry(paths[slots[slot].index], &results[slots[slot].index], options);
+  }
+}
+
+#endif
+
+void id3v2_load_batch(const char **paths, int count, id3v2_batch_result *results)
+{
+  id3v2_load_batch_with_options(paths, count, results, NULL);
+}
+
+// loads the first tag of every file, like id3v2_load_tag_from_file_with_options does for a single one,
+// but keeps many files in flight at once: through io_uring where the kernel offers it, through threads otherwise
+// the options are shared by all loads, so they must only contain thread safe pools and caches
+void id3v2_load_batch_with_options(const char **paths, int count, id3v2_batch_result *results, id3v2_load_options *options)
+{
+  int done = 0;
+#ifdef BATCH_IO_URING
+  batch_slot slots[ID3V2_BATCH_QUEUE_DEPTH];
+  batch_ring ring;
+  int slot;
+#endif
+
+  if(paths == NULL || results == NULL || count < 0)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return;
+  }
+
+#ifdef BATCH_IO_URING
+  if(_open_batch_ring(&ring, ID3V2_BATCH_QUEUE_DEPTH))
+  {
+    for(slot = 0; slot < ID3V2_BATCH_QUEUE_DEPTH; slot++)
+    {
+      slots[slot].index = -1;
+      slots[slot].buffer = NULL;
+    }
+
+    done = _load_batch_with_ring(&ring, slots, paths, count, results, options);
+    _close_batch_ring(&ring);
+    _finish_batch_slots(slots, paths, results, options);
+  }
+#endif
+
+  if(done < count)
+    _load_batch_with_threads(paths, done, count, results, options);
+
+  E_SUCCESS;
+}
@@ -0,0 +1,544 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // st_mtim
+#endif
+#ifdef __APPLE__
+#define _DARWIN_C_SOURCE // st_mtimespec
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "id3v2lib.h"
+
+// The cache file starts with TAG_CACHE_HEADER bytes: the magic "ID3CACHE" and the format version as 32 bit
+// little endian integer, padded with zeros. Records follow one after another, each made of
+//   device, inode, size, mtime in nanoseconds  4 x 64 bit little endian integers
+//   payload length                             32 bit little endian integer
+//   checksum                                   lower 32 bits of the xxHash64 of the payload
+//   payload                                    a tag as written by id3v2_write_tag_to_buffer, empty if the file has none
+// padded with zeros to a multiple of 8 bytes, so every record header stays aligned for readers mapping the file.
+// Records never get changed, a file which changed gets a new record and the last record of a key wins.
+// Processes sharing the file append under an fcntl() lock on the whole file.
+#define TAG_CACHE_MAGIC "ID3CACHE"
+#define TAG_CACHE_VERSION 1
+#define TAG_CACHE_HEADER 16
+#define TAG_CACHE_RECORD 40
+#define TAG_CACHE_ALIGNMENT 8
+#define TAG_CACHE_INITIAL_ENTRIES 1024 // needs to be a power of two
+
+typedef struct
+{
+  uint64_t device;
+  uint64_t inode;
+  int64_t size;
+  int64_t mtime;
+} tag_cache_key;
+
+typedef struct
+{
+  tag_cache_key key;
+  int64_t offset; // of the payload, 0 marks a free entry
+  int length;
+} tag_cache_entry;
+
+struct id3v2_tag_cache
+{
+  int fd;
+  char *map; // the records found when the cache got opened, newer ones get read from fd
+  int64_t map_size;
+  int64_t end; // where the next record goes
+  tag_cache_entry *entries;
+  int capacity;
+  int count;
+  id3v2_tag_cache_statistics statistics;
+  void *mutex;
+};
+
+static int _get_padded_length(int length)
+{
+  return (length + TAG_CACHE_ALIGNMENT - 1) & ~(TAG_CACHE_ALIGNMENT - 1);
+}
+
+static uint64_t _hash_tag_cache_key(tag_cache_key *key)
+{
+  char bytes[32];
+
+  _write_little_endian_to_buffer(bytes, key->device, 8);
+  _write_little_endian_to_buffer(bytes + 8, key->inode, 8);
+  _write_little_endian_to_buffer(bytes + 16, (uint64_t)key->size, 8);
+  _write_little_endian_to_buffer(bytes + 24, (uint64_t)key->mtime, 8);
+
+  return _xxhash64_buffer(bytes, sizeof(bytes), 0);
+}
+
+// returns the entry of the key, or the free entry it belongs into
+static tag_cache_entry *_find_tag_cache_entry(tag_cache_entry *entries, int capacity, tag_cache_key *key)
+{
+  int slot = (int)(_hash_tag_cache_key(key) & (capacity - 1));
+
+  while(entries[slot].offset != 0 && memcmp(&entries[slot].key, key, sizeof(tag_cache_key)) != 0)
+    slot = (slot + 1) & (capacity - 1);
+
+  return &entries[slot];
+}
+
+static int _add_tag_cache_entry(id3v2_tag_cache *cache, tag_cache_key *key, int64_t offset, int length)
+{
+  tag_cache_entry *entries;
+  tag_cache_entry *entry;
+  int i;
+
+  // keep the load factor below 1/2
+  if((cache->count + 1) * 2 > cache->capacity)
+  {
+    entries = (tag_cache_entry*)_allocate_zeroed(cache->capacity * 2, sizeof(tag_cache_entry));
+
+    if(entries == NULL)
+      return 0;
+
+    for(i = 0; i < cache->capacity; i++)
+    {
+      if(cache->entries[i].offset != 0)
+        *_find_tag_cache_entry(entries, cache->capacity * 2, &cache->entries[i].key) = cache->entries[i];
+    }
+
+    free(cache->entries);
+    cache->entries = entries;
+    cache->capacity *= 2;
+  }
+
+  entry = _find_tag_cache_entry(cache->entries, cache->capacity, key);
+
+  if(entry->offset == 0)
+    cache->count++;
+
+  entry->key = *key;
+  entry->offset = offset;
+  entry->length = length;
+
+  return 1;
+}
+
+// reads from the mapping where possible, returns the amount of bytes read
+static int _read_from_tag_cache(id3v2_tag_cache *cache, int64_t offset, char *buffer, int size)
+{
+  if(cache->map != NULL && offset + size <= cache->map_size)
+  {
+    memcpy(buffer, cache->map + offset, size);
+    return size;
+  }
+
+  return _read_from_fd(cache->fd, offset, buffer, size);
+}
+
+// indexes the records from offset on, the first damaged or incomplete one and everything behind it gets overwritten later
+static int _index_tag_cache(id3v2_tag_cache *cache, int64_t offset, int64_t length)
+{
+  uint64_t checked;
+  char *payload = NULL;
+  int payload_length;
+  char record[TAG_CACHE_RECORD];
+  tag_cache_key key;
+  char *resized_payload;
+
+  while(offset + TAG_CACHE_RECORD <= length &&
+        _read_from_tag_cache(cache, offset, record, TAG_CACHE_RECORD) == TAG_CACHE_RECORD)
+  {
+    // the payload length and the checksum share the last 64 bits of the record header
+    checked = _read_little_endian_from_buffer(record + 32, 8);
+    payload_length = (int)(checked & 0x7FFFFFFF);
+
+    if(payload_length != (int64_t)(checked & 0xFFFFFFFF) || offset + TAG_CACHE_RECORD + payload_length > length)
+      break;
+
+    resized_payload = (char*)_reallocate(payload, payload_length > 0 ? payload_length : 1);
+    if(resized_payload == NULL)
+      break;
+    payload = resized_payload;
+
+    if(_read_from_tag_cache(cache, offset + TAG_CACHE_RECORD, payload, payload_length) != payload_length ||
+       (_xxhash64_buffer(payload, payload_length, 0) & 0xFFFFFFFF) != checked >> 32)
+      break;
+
+    key.device = _read_little_endian_from_buffer(record, 8);
+    key.inode = _read_little_endian_from_buffer(record + 8, 8);
+    key.size = (int64_t)_read_little_endian_from_buffer(record + 16, 8);
+    key.mtime = (int64_t)_read_little_endian_from_buffer(record + 24, 8);
+
+    if(!_add_tag_cache_entry(cache, &key, offset + TAG_CACHE_RECORD, payload_length))
+      break;
+
+    offset += TAG_CACHE_RECORD + _get_padded_length(payload_length);
+  }
+
+  free(payload);
+
+  cache->end = offset;
+
+  return 1;
+}
+
+// opens the cache file at path, which gets created if it doesn't exist yet
+id3v2_tag_cache *id3v2_open_tag_cache(const char *path)
+{
+  id3v2_tag_cache *cache;
+  char header[TAG_CACHE_HEADER];
+  int64_t length;
+
+  if(path == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    return NULL;
+  }
+
+  cache = (id3v2_tag_cache*)_allocate_zeroed(1, sizeof(id3v2_tag_cache));
+
+  if(cache == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+#ifdef _WIN32
+  cache->fd = _open(path, _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+  cache->fd = open(path, O_RDWR | O_CREAT, 0644);
+#endif
+
+  if(cache->fd < 0)
+  {
+    free(cache);
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    return NULL;
+  }
+
+  cache->capacity = TAG_CACHE_INITIAL_ENTRIES;
+  cache->entries = (tag_cache_entry*)_allocate_zeroed(cache->capacity, sizeof(tag_cache_entry));
+  cache->mutex = _new_mutex();
+
+  if(cache->entries == NULL || cache->mutex == NULL)
+  {
+    id3v2_close_tag_cache(cache);
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  length = _get_length_of_fd(cache->fd);
+
+  if(length < TAG_CACHE_HEADER)
+  {
+    // a new cache
+    memset(header, 0, sizeof(header));
+    memcpy(header, TAG_CACHE_MAGIC, 8);
+    header[8] = TAG_CACHE_VERSION;
+
+    if(_write_to_fd(cache->fd, 0, header, TAG_CACHE_HEADER) != TAG_CACHE_HEADER)
+    {
+      id3v2_close_tag_cache(cache);
+      E_FAIL(ID3V2_ERROR_IO);
+      return NULL;
+    }
+
+    cache->end = TAG_CACHE_HEADER;
+
+    E_SUCCESS;
+
+    return cache;
+  }
+
+  if(_read_from_fd(cache->fd, 0, header, TAG_CACHE_HEADER) != TAG_CACHE_HEADER ||
+     memcmp(header, TAG_CACHE_MAGIC, 8) != 0 || header[8] != TAG_CACHE_VERSION)
+  {
+    id3v2_close_tag_cache(cache);
+    E_FAIL(ID3V2_ERROR_UNSUPPORTED);
+    return NULL;
+  }
+
+#ifndef _WIN32
+  cache->map = (char*)mmap(NULL, (size_t)length, PROT_READ, MAP_SHARED, cache->fd, 0);
+
+  if(cache->map == MAP_FAILED)
+    cache->map = NULL; // everything gets read from the descriptor then
+  else
+    cache->map_size = length;
+#endif
+
+  _index_tag_cache(cache, TAG_CACHE_HEADER, length);
+
+  E_SUCCESS;
+
+  return cache;
+}
+
+void id3v2_close_tag_cache(id3v2_tag_cache *cache)
+{
+  if(cache == NULL)
+    return;
+
+#ifndef _WIN32
+  if(cache->map != NULL)
+    munmap(cache->map, (size_t)cache->map_size);
+#endif
+
+#ifdef _WIN32
+  _close(cache->fd);
+#else
+  close(cache->fd);
+#endif
+
+  free(cache->entries);
+  _free_mutex(cache->mutex);
+  free(cache);
+
+  E_SUCCESS;
+}
+
+static int _get_tag_cache_key_from_path(const char *path, tag_cache_key *key)
+{
+#ifdef _WIN32
+  struct _stati64 status;
+
+  if(_stati64(path, &status) != 0)
+    return 0;
+#else
+  struct stat status;
+
+  if(stat(path, &status) != 0)
+    return 0;
+#endif
+
+  memset(key, 0, sizeof(tag_cache_key));
+  key->device = (uint64_t)status.st_dev;
+  key->inode = (uint64_t)status.st_ino;
+  key->size = (int64_t)status.st_size;
+#if defined(_WIN32)
+  key->mtime = (int64_t)status.st_mtime * 1000000000;
+#elif defined(__APPLE__)
+  key->mtime = (int64_t)status.st_mtimespec.tv_sec * 1000000000 + status.st_mtimespec.tv_nsec;
+#else
+  key->mtime = (int64_t)status.st_mtim.tv_sec * 1000000000 + status.st_mtim.tv_nsec;
+#endif
+
+  return 1;
+}
+
+// several processes may append to the same cache file, so they take turns through a lock on the whole file
+// there is no such lock on Windows, only one process may write to a cache there
+static int _lock_tag_cache_file(id3v2_tag_cache *cache, int locked)
+{
+#ifdef _WIN32
+  return 1;
+#else
+  struct flock lock;
+
+  memset(&lock, 0, sizeof(lock));
+  lock.l_type = locked ? F_WRLCK : F_UNLCK;
+  lock.l_whence = SEEK_SET;
+
+  return fcntl(cache->fd, F_SETLKW, &lock) == 0;
+#endif
+}
+
+// appends a record for the key, a NULL tag is remembered as a file without a tag
+static void _store_tag_in_tag_cache(id3v2_tag_cache *cache, tag_cache_key *key, id3v2_tag *tag)
+{
+  char *payload = NULL;
+  size_t payload_size = 0;
+  int payload_length;
+  int64_t offset;
+  char *record;
+  int record_length;
+  uint64_t checksum;
+
+  if(tag != NULL)
+  {
+    payload = id3v2_write_tag_to_buffer(tag, &payload_size);
+    if(payload == NULL)
+      return;
+  }
+
+  payload_length = (int)payload_size; // the writer keeps tags below 2^28 bytes
+
+  record_length = TAG_CACHE_RECORD + _get_padded_length(payload_length);
+  record = (char*)_allocate_zeroed(record_length, 1);
+
+  if(record == NULL)
+  {
+    free(payload);
+    return;
+  }
+
+  checksum = _xxhash64_buffer(payload != NULL ? payload : "", payload_length, 0);
+
+  _write_little_endian_to_buffer(record, key->device, 8);
+  _write_little_endian_to_buffer(record + 8, key->inode, 8);
+  _write_little_endian_to_buffer(record + 16, (uint64_t)key->size, 8);
+  _write_little_endian_to_buffer(record + 24, (uint64_t)key->mtime, 8);
+  _write_little_endian_to_buffer(record + 32, (uint64_t)(uint32_t)payload_length | (checksum & 0xFFFFFFFF) << 32, 8);
+
+  if(payload_length > 0)
+    memcpy(record + TAG_CACHE_RECORD, payload, payload_length);
+
+  free(payload);
+
+  _lock_mutex(cache->mutex);
+
+  if(_lock_tag_cache_file(cache, 1))
+  {
+    // records other processes appended since are indexed first, the new one goes behind them
+    _index_tag_cache(cache, cache->end, _get_length_of_fd(cache->fd));
+    offset = cache->end;
+
+    if(_write_to_fd(cache->fd, offset, record, record_length) == record_length)
+    {
+      cache->end += record_length;
+      _add_tag_cache_entry(cache, key, offset + TAG_CACHE_RECORD, payload_length);
+    }
+
+    _lock_tag_cache_file(cache, 0);
+  }
+
+  _unlock_mutex(cache->mutex);
+
+  free(record);
+}
+
+// like id3v2_load_tag_from_file_with_options, but files which didn't change since they got loaded last time
+// are neither read nor parsed again, their tag comes from the cache
+id3v2_tag *id3v2_load_tag_from_path_with_cache(id3v2_tag_cache *cache, const char *path, id3v2_load_options *options)
+{
+  tag_cache_entry entry;
+  unsigned short error;
+  FILE *file;
+  tag_cache_entry *found;
+  char has_key;
+  tag_cache_key key;
+  char *payload;
+  int64_t start = _get_monotonic_nanoseconds();
+  id3v2_tag *tag;
+
+  if(path == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    return NULL;
+  }
+
+  has_key = cache != NULL && _get_tag_cache_key_from_path(path, &key);
+
+  if(has_key)
+  {
+    _lock_mutex(cache->mutex);
+    found = _find_tag_cache_entry(cache->entries, cache->capacity, &key);
+    entry = *found;
+    _unlock_mutex(cache->mutex);
+
+    if(entry.offset != 0)
+    {
+      tag = NULL;
+      error = ID3V2_ERROR_NOT_FOUND;
+
+      if(entry.length > 0 && (payload = (char*)_allocate(entry.length)) != NULL)
+      {
+        if(_read_from_tag_cache(cache, entry.offset, payload, entry.length) == entry.length)
+        {
+          tag = id3v2_load_tag_from_buffer_with_options(payload, entry.length, options);
+          error = E_GET;
+        }
+        else
+          error = ID3V2_ERROR_IO;
+        free(payload);
+      }
+
+      _lock_mutex(cache->mutex);
+      cache->statistics.hits++;
+      cache->statistics.hit_nanoseconds += _get_monotonic_nanoseconds() - start;
+      _unlock_mutex(cache->mutex);
+
+      E_FAIL(error);
+
+      return tag;
+    }
+  }
+
+  file = fopen(path, "rb");
+
+  if(file == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    return NULL;
+  }
+
+  tag = id3v2_load_tag_from_file_with_options(file, options);
+  error = E_GET;
+  fclose(file);
+
+  if(has_key)
+  {
+    // files without a tag are worth remembering too, failures reading them are not
+    if(tag != NULL || error == ID3V2_ERROR_NOT_FOUND)
+      _store_tag_in_tag_cache(cache, &key, tag);
+
+    _lock_mutex(cache->mutex);
+    cache->statistics.misses++;
+    cache->statistics.miss_nanoseconds += _get_monotonic_nanoseconds() - start;
+    _unlock_mutex(cache->mutex);
+  }
+
+  E_FAIL(error);
+
+  return tag;
+}
+
+void id3v2_get_statistics_from_tag_cache(id3v2_tag_cache *cache, id3v2_tag_cache_statistics *statistics)
+{
+  if(cache == NULL || statistics == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return;
+  }
+
+  _lock_mutex(cache->mutex);
+  *statistics = cache->statistics;
+  _unlock_mutex(cache->mutex);
+
+  E_SUCCESS;
+}
+
+int id3v2_get_entry_count_from_tag_cache(id3v2_tag_cache *cache)
+{
+  int count;
+
+  if(cache == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  _lock_mutex(cache->mutex);
+  count = cache->count;
+  _unlock_mutex(cache->mutex);
+
+  E_SUCCESS;
+
+  return count;
+}
@@ -0,0 +1,444 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+#define CHAPTER_TIMES 16 // start time, end time, start offset and end offset
+#define TABLE_OF_CONTENTS_TOP_LEVEL 0x02
+#define TABLE_OF_CONTENTS_ORDERED 0x01
+
+struct id3v2_chapter_index
+{
+  uint32_t *start_times; // sorted, kept apart from the chapters so the search only touches these
+  uint32_t *latest_end_times; // the latest end time of the chapters up to this one
+  id3v2_chapter *chapters; // in the order of start_times
+  int chapter_count;
+  id3v2_table_of_contents *tables;
+  int table_count;
+};
+
+static uint32_t _read_big_endian(const char *bytes)
+{
+  return (uint32_t)(unsigned char)bytes[0] << 24 | (uint32_t)(unsigned char)bytes[1] << 16 |
+         (uint32_t)(unsigned char)bytes[2] << 8 | (uint32_t)(unsigned char)bytes[3];
+}
+
+// returns the index of the terminator behind the element ID, or -1 if there is none
+static int _read_element_id(id3v2_frame *frame, id3v2_text_view *element_id)
+{
+  char *end = memchr(frame->data, '\0', frame->size);
+
+  if(end == NULL)
+    return -1;
+
+  element_id->text = frame->data;
+  element_id->size = (int)(end - frame->data);
+  element_id->encoding = ID3V2_ISO_ENCODING;
+
+  return element_id->size;
+}
+
+static int _parse_chapter(id3v2_frame *frame, id3v2_chapter *chapter)
+{
+  int offset = _read_element_id(frame, &chapter->element_id) + 1;
+
+  if(offset <= 0 || offset + CHAPTER_TIMES > frame->size)
+    return 0;
+
+  chapter->start_time = _read_big_endian(frame->data + offset);
+  chapter->end_time = _read_big_endian(frame->data + offset + 4);
+  chapter->start_offset = _read_big_endian(frame->data + offset + 8);
+  chapter->end_offset = _read_big_endian(frame->data + offset + 12);
+  chapter->frame = frame;
+  chapter->embedded_frames = frame->data + offset + CHAPTER_TIMES;
+  chapter->embedded_size = frame->size - offset - CHAPTER_TIMES;
+  chapter->embedded_tag = NULL;
+
+  return 1;
+}
+
+static int _parse_table_of_contents(id3v2_frame *frame, id3v2_table_of_contents *table)
+{
+  int offset = _read_element_id(frame, &table->element_id) + 1;
+  int i;
+
+  if(offset <= 0 || offset + 2 > frame->size)
+    return 0;
+
+  table->top_level = (frame->data[offset] & TABLE_OF_CONTENTS_TOP_LEVEL) != 0;
+  table->ordered = (frame->data[offset] & TABLE_OF_CONTENTS_ORDERED) != 0;
+  table->entry_count = (unsigned char)frame->data[offset + 1];
+  table->entries = frame->data + offset + 2;
+  offset += 2;
+
+  for(i = 0; i < table->entry_count; i++)
+  {
+    while(offset < frame->size && frame->data[offset] != '\0')
+      offset++;
+
+    if(offset >= frame->size)
+      return 0;
+
+    offset++;
+  }
+
+  table->entries_size = (int)(frame->data + offset - table->entries);
+  table->frame = frame;
+  table->embedded_frames = frame->data + offset;
+  table->embedded_size = frame->size - offset;
+  table->embedded_tag = NULL;
+
+  return 1;
+}
+
+typedef struct
+{
+  uint32_t start_time;
+  int position; // of the frame in the tag
+} chapter_order;
+
+// chapters starting at the same time keep the order of their frames
+static int _compare_chapters(const void *a, const void *b)
+{
+  const chapter_order *first = (const chapter_order*)a;
+  const chapter_order *second = (const chapter_order*)b;
+
+  if(first->start_time != second->start_time)
+    return first->start_time < second->start_time ? -1 : 1;
+
+  return first->position - second->position;
+}
+
+static void _free_chapter_index(id3v2_chapter_index *index)
+{
+  int i;
+
+  for(i = 0; i < index->chapter_count; i++)
+    if(index->chapters[i].embedded_tag != NULL)
+      id3v2_free_tag(index->chapters[i].embedded_tag);
+
+  for(i = 0; i < index->table_count; i++)
+    if(index->tables[i].embedded_tag != NULL)
+      id3v2_free_tag(index->tables[i].embedded_tag);
+
+  free(index->start_times);
+  free(index->latest_end_times);
+  free(index->chapters);
+  free(index->tables);
+  free(index);
+}
+
+// puts the chapters, which are in the order of their frames, in the order of their start times
+static int _sort_chapters(id3v2_chapter_index *index)
+{
+  chapter_order *order = (chapter_order*)_allocate((index->chapter_count + 1) * sizeof(chapter_order));
+  id3v2_chapter *chapters = (id3v2_chapter*)_allocate((index->chapter_count + 1) * sizeof(id3v2_chapter));
+  int i;
+
+  if(order == NULL || chapters == NULL)
+  {
+    free(order);
+    free(chapters);
+    return 0;
+  }
+
+  for(i = 0; i < index->chapter_count; i++)
+  {
+    order[i].start_time = index->chapters[i].start_time;
+    order[i].position = i;
+  }
+
+  qsort(order, index->chapter_count, sizeof(chapter_order), _compare_chapters);
+
+  for(i = 0; i < index->chapter_count; i++)
+    chapters[i] = index->chapters[order[i].position];
+
+  free(index->chapters);
+  free(order);
+  index->chapters = chapters;
+
+  return 1;
+}
+
+static id3v2_chapter_index *_build_chapter_index(id3v2_tag *tag)
+{
+  id3v2_chapter_index *index;
+  id3v2_frame *frame;
+  int chapter_count = 0;
+  int table_count = 0;
+  int kind;
+  int i;
+
+  for(frame = tag->frame; frame != NULL; frame = frame->next)
+  {
+    kind = _get_frame_kind_from_id(frame->id, frame->version);
+    chapter_count += kind == ID3V2_KIND_CHAP;
+    table_count += kind == ID3V2_KIND_CTOC;
+  }
+
+  index = (id3v2_chapter_index*)_allocate_zeroed(1, sizeof(id3v2_chapter_index));
+
+  if(index == NULL)
+    return NULL;
+
+  // one more, so tags without chapters don't ask for zero bytes
+  index->start_times = (uint32_t*)_allocate((chapter_count + 1) * sizeof(uint32_t));
+  index->latest_end_times = (uint32_t*)_allocate((chapter_count + 1) * sizeof(uint32_t));
+  index->chapters = (id3v2_chapter*)_allocate((chapter_count + 1) * sizeof(id3v2_chapter));
+  index->tables = (id3v2_table_of_contents*)_allocate((table_count + 1) * sizeof(id3v2_table_of_contents));
+
+  if(index->start_times == NULL || index->latest_end_times == NULL || index->chapters == NULL || index->tables == NULL)
+  {
+    _free_chapter_index(index);
+    return NULL;
+  }
+
+  for(frame = tag->frame; frame != NULL; frame = frame->next)
+  {
+    kind = _get_frame_kind_from_id(frame->id, frame->version);
+
+    if(kind == ID3V2_KIND_CHAP && _parse_chapter(frame, &index->chapters[index->chapter_count]))
+      index->chapter_count++;
+    else if(kind == ID3V2_KIND_CTOC && _parse_table_of_contents(frame, &index->tables[index->table_count]))
+      index->table_count++;
+  }
+
+  if(!_sort_chapters(index))
+  {
+    _free_chapter_index(index);
+    return NULL;
+  }
+
+  for(i = 0; i < index->chapter_count; i++)
+  {
+    index->start_times[i] = index->chapters[i].start_time;
+    index->latest_end_times[i] = index->chapters[i].end_time;
+    if(i > 0 && index->latest_end_times[i - 1] > index->latest_end_times[i])
+      index->latest_end_times[i] = index->latest_end_times[i - 1];
+  }
+
+  return index;
+}
+
+static id3v2_chapter_index *_get_chapter_index_of_tag(id3v2_tag *tag)
+{
+  if(tag == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  if(tag->chapters == NULL)
+  {
+    tag->chapters = _build_chapter_index(tag);
+
+    if(tag->chapters == NULL)
+    {
+      E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+      return NULL;
+    }
+  }
+
+  E_SUCCESS;
+
+  return tag->chapters;
+}
+
+// the embedded frames are read like the frames of the tag they are in
+static id3v2_tag *_parse_embedded_frames(id3v2_tag *tag, char *bytes, int size)
+{
+  id3v2_tag *embedded_tag = id3v2_new_tag();
+
+  if(embedded_tag == NULL)
+    return NULL;
+
+  // the unsynchronisation of the whole tag is reversed already
+  *embedded_tag->header = *tag->header;
+  embedded_tag->header->flags = 0;
+  embedded_tag->header->tag_size = size;
+  embedded_tag->header->extended_header_size = 0;
+
+  _parse_frames_into_tag(embedded_tag, bytes, size, NULL);
+
+  return embedded_tag;
+}
+
+// drops the chapters along with their embedded frames, the next chapter lookup finds them again
+void _free_chapter_index_of_tag(id3v2_tag *tag)
+{
+  if(tag->chapters == NULL)
+    return;
+
+  _free_chapter_index(tag->chapters);
+  tag->chapters = NULL;
+}
+
+int id3v2_get_chapter_count_from_tag(id3v2_tag *tag)
+{
+  id3v2_chapter_index *index = _get_chapter_index_of_tag(tag);
+
+  return index != NULL ? index->chapter_count : 0;
+}
+
+// chapters are sorted by their start time
+id3v2_chapter *id3v2_get_chapter_from_tag(id3v2_tag *tag, int chapter_index)
+{
+  id3v2_chapter_index *index = _get_chapter_index_of_tag(tag);
+
+  if(index == NULL)
+    return NULL;
+
+  if(chapter_index < 0 || chapter_index >= index->chapter_count)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  return &index->chapters[chapter_index];
+}
+
+// returns the chapter playing at the given time, of overlapping ones the one which started last
+id3v2_chapter *id3v2_get_chapter_at_time_from_tag(id3v2_tag *tag, uint32_t milliseconds)
+{
+  id3v2_chapter_index *index = _get_chapter_index_of_tag(tag);
+  int high;
+  int low = 0;
+  int middle;
+  int i;
+
+  if(index == NULL)
+    return NULL;
+
+  // the first chapter starting after the time
+  high = index->chapter_count;
+  while(low < high)
+  {
+    middle = low + (high - low) / 2;
+    if(index->start_times[middle] <= milliseconds)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  // usually the one in front of it, walking back only while an earlier chapter may still be playing
+  for(i = low - 1; i >= 0 && index->latest_end_times[i] > milliseconds; i--)
+  {
+    if(index->chapters[i].end_time > milliseconds)
+      return &index->chapters[i];
+  }
+
+  E_FAIL(ID3V2_ERROR_NOT_FOUND);
+
+  return NULL;
+}
+
+id3v2_chapter *id3v2_find_chapter_in_tag(id3v2_tag *tag, const char *element_id)
+{
+  id3v2_chapter_index *index = _get_chapter_index_of_tag(tag);
+  int size;
+  int i;
+
+  if(index == NULL)
+    return NULL;
+
+  size = element_id != NULL ? (int)strlen(element_id) : -1;
+
+  for(i = 0; i < index->chapter_count; i++)
+  {
+    if(index->chapters[i].element_id.size == size && memcmp(index->chapters[i].element_id.text, element_id, size) == 0)
+      return &index->chapters[i];
+  }
+
+  E_FAIL(ID3V2_ERROR_NOT_FOUND);
+
+  return NULL;
+}
+
+int id3v2_get_table_of_contents_count_from_tag(id3v2_tag *tag)
+{
+  id3v2_chapter_index *index = _get_chapter_index_of_tag(tag);
+
+  return index != NULL ? index->table_count : 0;
+}
+
+// tables of contents keep the order of their frames
+id3v2_table_of_contents *id3v2_get_table_of_contents_from_tag(id3v2_tag *tag, int table_index)
+{
+  id3v2_chapter_index *index = _get_chapter_index_of_tag(tag);
+
+  if(index == NULL)
+    return NULL;
+
+  if(table_index < 0 || table_index >= index->table_count)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  return &index->tables[table_index];
+}
+
+// returns the frames embedded into the chapter as a tag, which belongs to the chapter
+id3v2_tag *id3v2_get_tag_from_chapter(id3v2_chapter *chapter)
+{
+  if(chapter == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  if(chapter->embedded_tag == NULL)
+    chapter->embedded_tag = _parse_embedded_frames(chapter->frame->tag, chapter->embedded_frames, chapter->embedded_size);
+
+  if(chapter->embedded_tag == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  E_SUCCESS;
+
+  return chapter->embedded_tag;
+}
+
+id3v2_tag *id3v2_get_tag_from_table_of_contents(id3v2_table_of_contents *table)
+{
+  if(table == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  if(table->embedded_tag == NULL)
+    table->embedded_tag = _parse_embedded_frames(table->frame->tag, table->embedded_frames, table->embedded_size);
+
+  if(table->embedded_tag == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  E_SUCCESS;
+
+  return table->embedded_tag;
+}
+
+// the image of the chapter, its frames only get parsed once something is asked of them
+id3v2_frame *id3v2_get_picture_frame_from_chapter(id3v2_chapter *chapter)
+{
+  id3v2_tag *embedded_tag = id3v2_get_tag_from_chapter(chapter);
+
+  if(embedded_tag == NULL)
+    return NULL;
+
+  return id3v2_get_frame_from_tag(embedded_tag, ID3V2_GET_ALBUM_COVER_FRAME_ID_FROM_TAG(embedded_tag));
+}
@@ -0,0 +1,302 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "id3v2lib.h"
+
+#define COUNTER_WINDOW 4096 // frame headers get read this many bytes at a time
+
+// the part of the file the frame headers currently get read from
+typedef struct
+{
+  id3v2_io *io;
+  int64_t offset;
+  int size;
+  char bytes[COUNTER_WINDOW];
+} counter_window;
+
+// returns the size bytes at offset, reading the window there if they aren't in it yet
+static char *_read_counter_window(counter_window *window, int64_t offset, int size)
+{
+  if(offset < window->offset || offset + size > window->offset + window->size)
+  {
+    window->offset = offset;
+    window->size = _read_from_io(window->io, offset, window->bytes, COUNTER_WINDOW);
+  }
+
+  if(offset + size > window->offset + window->size)
+    return NULL;
+
+  return window->bytes + (offset - window->offset);
+}
+
+// returns the offset of the first tag of the file, -1 if it has none
+static int64_t _get_offset_of_first_tag(counter_window *window)
+{
+  char *header = _read_counter_window(window, 0, ID3V2_HEADER);
+  int64_t *offsets;
+  int64_t offset;
+  int count;
+
+  // usually right at the start, like id3v2_load_tag_from_fd() expects it
+  if(header != NULL && _has_buffer_id3v2tag(header))
+    return 0;
+
+  _locate_header_offsets(window->io, _get_size_of_io(window->io), &offsets, &count);
+
+  if(count == 0)
+    return -1;
+
+  offset = offsets[0];
+  free(offsets);
+
+  return offset;
+}
+
+// the counter of PCNT is the whole frame, the one of POPM follows the email and the rating
+static int _get_offset_of_counter(char *data, int size, int kind)
+{
+  char *end;
+
+  if(kind == ID3V2_KIND_PCNT)
+    return 0;
+
+  end = memchr(data, '\0', size);
+
+  return end != NULL && end + 2 <= data + size ? (int)(end - data) + 2 : -1;
+}
+
+// tells whether the POPM frame at offset belongs to the email, compared byte by byte with the one in the frame
+static int _has_counter_email(counter_window *window, int64_t offset, int size, const char *email)
+{
+  int email_size = (int)strlen(email) + 1;
+  char *data;
+  int result;
+
+  if(email_size > size)
+    return 0;
+
+  data = (char*)_allocate(email_size);
+
+  if(data == NULL)
+    return 0;
+
+  result = _read_from_io(window->io, offset, data, email_size) == email_size && memcmp(data, email, email_size) == 0;
+  free(data);
+
+  return result;
+}
+
+// overwrites the counter in the data of the frame at offset, and the rating of POPM unless it's -1, if the value fits
+static int _write_counter_to_frame(int fd, counter_window *window, int64_t offset, int size, int kind, int rating, uint64_t value)
+{
+  char *data = (char*)_allocate(size * 2 + 1); // the frame followed by the new rating and counter
+  char *counter;
+  int counter_offset;
+  int counter_size;
+  int write_offset;
+  int i;
+
+  if(data == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return 0;
+  }
+
+  if(_read_from_io(window->io, offset, data, size) != size || (counter_offset = _get_offset_of_counter(data, size, kind)) < 0)
+  {
+    free(data);
+    E_FAIL(ID3V2_ERROR_INSUFFICIENT_DATA);
+    return 0;
+  }
+
+  counter = data + size + 1;
+  counter_size = size - counter_offset;
+
+  // a larger counter means growing the frame, which only a rewrite of the tag can do
+  if(counter_size < 8 && (value >> (counter_size * 8)) != 0)
+  {
+    free(data);
+    E_FAIL(ID3V2_ERROR_INSUFFICIENT_DATA);
+    return 0;
+  }
+
+  for(i = 0; i < counter_size; i++)
+    counter[i] = i < counter_size - 8 ? 0 : (char)(value >> ((counter_size - 1 - i) * 8));
+
+  // the rating sits right in front of the counter, so both get written at once
+  write_offset = counter_offset;
+  if(kind == ID3V2_KIND_POPM && rating >= 0)
+  {
+    counter[-1] = (char)rating;
+    write_offset--;
+  }
+
+  // the file already holds the values, so it stays untouched
+  if(memcmp(data + write_offset, counter - (counter_offset - write_offset), size - write_offset) != 0 &&
+     _write_to_fd(fd, offset + write_offset, counter - (counter_offset - write_offset), size - write_offset) != size - write_offset)
+  {
+    free(data);
+    E_FAIL(ID3V2_ERROR_IO);
+    return 0;
+  }
+
+  free(data);
+
+  E_SUCCESS;
+
+  return 1;
+}
+
+// sets the counter of the first PCNT frame, or of the POPM frame of the email, to value, writing only the bytes of
+// the counter. A NULL email takes the first POPM frame, the rating of POPM gets replaced as well unless it's -1.
+// Returns 0 and fails with ID3V2_ERROR_INSUFFICIENT_DATA if the value needs a larger frame, the tag has to be
+// rewritten then. Unsynchronised or compressed tags and compressed or encrypted frames fail with ID3V2_ERROR_UNSUPPORTED.
+int id3v2_update_counter_in_fd(int fd, const char *frame_id, const char *email, int rating, uint64_t value)
+{
+  counter_window window;
+  id3v2_io io;
+  char *header;
+  int64_t tag_offset;
+  int64_t position;
+  int64_t end;
+  int extended_header_size = 0;
+  int frame_header_size;
+  int frame_size;
+  int flags;
+  int kind;
+  int version;
+
+  if(frame_id == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  if(rating < -1 || rating > 255)
+  {
+    E_FAIL(ID3V2_ERROR_UNSUPPORTED);
+    return 0;
+  }
+
+  id3v2_initialize_io_from_fd(&io, fd);
+  window.io = &io;
+  window.offset = 0;
+  window.size = 0;
+
+  tag_offset = _get_offset_of_first_tag(&window);
+  header = tag_offset >= 0 ? _read_counter_window(&window, tag_offset, ID3V2_HEADER + ID3V2_EXTENDED_HEADER_SIZE) : NULL;
+
+  if(header == NULL || !_has_buffer_id3v2tag(header))
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  version = header[3];
+  flags = (unsigned char)header[5];
+  kind = _get_frame_kind_from_id(frame_id, version);
+
+  // in 2.2 the flag of the extended header means the whole tag is compressed
+  if((kind != ID3V2_KIND_PCNT && kind != ID3V2_KIND_POPM) || (flags & 0x80) || (version == ID3V2_2 && (flags & 0x40)))
+  {
+    E_FAIL(ID3V2_ERROR_UNSUPPORTED);
+    return 0;
+  }
+
+  if(flags & 0x40)
+  {
+    if(version == ID3V2_4)
+      extended_header_size = syncint_decode(btoi(header, ID3V2_EXTENDED_HEADER_SIZE, ID3V2_HEADER));
+    else
+      extended_header_size = btoi(header, ID3V2_EXTENDED_HEADER_SIZE, ID3V2_HEADER) + ID3V2_EXTENDED_HEADER_SIZE;
+  }
+
+  end = tag_offset + ID3V2_HEADER + syncint_decode(btoi(header, ID3V2_HEADER_SIZE, 6));
+  position = tag_offset + ID3V2_HEADER + extended_header_size;
+  frame_header_size = ID3V2_DECIDE_FRAME(version, ID3V2_FRAME_ID2 + ID3V2_FRAME_SIZE2, ID3V2_FRAME);
+
+  // the same walk as the loader's, without reading anything but the headers
+  while(position + frame_header_size <= end && (header = _read_counter_window(&window, position, frame_header_size)) != NULL)
+  {
+    if(!_is_valid_frame_id(header, version))
+      break; // padding reached
+
+    frame_size = btoi(header, ID3V2_DECIDE_FRAME(version, ID3V2_FRAME_SIZE2, ID3V2_FRAME_SIZE), ID3V2_DECIDE_FRAME(version, ID3V2_FRAME_ID2, ID3V2_FRAME_ID));
+    if(version == ID3V2_4)
+      frame_size = syncint_decode(frame_size);
+
+    if(frame_size < 0 || frame_size > end - position - frame_header_size)
+      break;
+
+    if(memcmp(header, frame_id, ID3V2_DECIDE_FRAME(version, ID3V2_FRAME_ID2, ID3V2_FRAME_ID)) == 0)
+    {
+      if((version == ID3V2_3 && (header[9] & 0xE0)) || // compressed, encrypted or grouped
+         (version == ID3V2_4 && (header[9] & 0x4F))) // grouped, compressed, encrypted, unsynchronised or with a data length
+      {
+        E_FAIL(ID3V2_ERROR_UNSUPPORTED);
+        return 0;
+      }
+
+      if(kind == ID3V2_KIND_PCNT || email == NULL || _has_counter_email(&window, position + frame_header_size, frame_size, email))
+        return _write_counter_to_frame(fd, &window, position + frame_header_size, frame_size, kind, rating, value);
+    }
+
+    position += frame_header_size + frame_size;
+  }
+
+  E_FAIL(ID3V2_ERROR_NOT_FOUND);
+
+  return 0;
+}
+
+// tags already loaded from the file don't see the new value
+int id3v2_update_counter_in_file(const char *path, const char *frame_id, const char *email, int rating, uint64_t value)
+{
+  int fd;
+  int result;
+
+  if(path == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    return 0;
+  }
+
+#ifdef _WIN32
+  fd = _open(path, _O_RDWR | _O_BINARY);
+#else
+  fd = open(path, O_RDWR);
+#endif
+
+  if(fd < 0)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    return 0;
+  }
+
+  result = id3v2_update_counter_in_fd(fd, frame_id, email, rating, value);
+
+#ifdef _WIN32
+  _close(fd);
+#else
+  close(fd);
+#endif
+
+  return result;
+}
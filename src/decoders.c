@@ -0,0 +1,643 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+#define TIMESTAMP_SIZE 4
+#define TIMESTAMP_FORMAT_SIZE 1
+#define EVENT_SIZE (1 + TIMESTAMP_SIZE) // its type and time stamp
+#define UNIQUE_KEY_PREFIX 3 // the language or the picture type in front of the text of a key
+
+struct id3v2_decoded_frame
+{
+  int kind; // the frame got decoded as this kind, a new ID means decoding again
+  union
+  {
+    id3v2_user_text_content user_text;
+    id3v2_url_content url;
+    id3v2_lyrics_content lyrics;
+    id3v2_synchronised_lyrics_content synchronised_lyrics;
+    id3v2_event_timing_content event_timing;
+    id3v2_popularimeter_content popularimeter;
+    id3v2_play_counter_content play_counter;
+    id3v2_unique_file_identifier_content unique_file_identifier;
+    id3v2_private_content private_data;
+    id3v2_general_object_content general_object;
+    id3v2_music_cd_identifier_content music_cd_identifier;
+    id3v2_relative_volume_content relative_volume;
+  } content;
+};
+
+// moves the cursor behind the string which starts there and its terminator
+// a string running into the end of the frame ends there
+void _read_text_view(char **cursor, char *end, char encoding, id3v2_text_view *view)
+{
+  char *text = *cursor;
+  int wide = encoding == ID3V2_UTF_16_ENCODING_WITH_BOM || encoding == ID3V2_UTF_16_ENCODING_WITHOUT_BOM;
+
+  view->text = text;
+  view->encoding = encoding;
+
+  if(wide)
+  {
+    while(text + 1 < end && (text[0] != '\0' || text[1] != '\0'))
+      text += 2;
+    view->size = (int)(text - view->text);
+    *cursor = text + 1 < end ? text + 2 : end;
+  }
+  else
+  {
+    while(text < end && *text != '\0')
+      text++;
+    view->size = (int)(text - view->text);
+    *cursor = text < end ? text + 1 : end;
+  }
+}
+
+// big endian counters may be longer than 8 bytes, those saturate
+static uint64_t _read_counter(char *data, int size)
+{
+  uint64_t counter = 0;
+  int i;
+
+  for(i = 0; i < size; i++)
+  {
+    if(counter > (UINT64_MAX >> 8))
+      return UINT64_MAX;
+    counter = counter << 8 | (unsigned char)data[i];
+  }
+
+  return counter;
+}
+
+static int _decode_user_text(id3v2_frame *frame, id3v2_user_text_content *content, int kind)
+{
+  char *cursor = frame->data + ID3V2_FRAME_ENCODING;
+  char *end = frame->data + frame->size;
+
+  if(frame->size < ID3V2_FRAME_ENCODING)
+    return 0;
+
+  _read_text_view(&cursor, end, frame->data[0], &content->description);
+
+  if(kind == ID3V2_KIND_WXXX)
+  {
+    content->value.text = cursor;
+    content->value.size = (int)(end - cursor);
+    content->value.encoding = ID3V2_ISO_ENCODING;
+  }
+  else
+    _read_text_view(&cursor, end, frame->data[0], &content->value);
+
+  return 1;
+}
+
+static int _decode_url(id3v2_frame *frame, id3v2_url_content *content)
+{
+  char *cursor = frame->data;
+
+  _read_text_view(&cursor, frame->data + frame->size, ID3V2_ISO_ENCODING, &content->url);
+
+  return 1;
+}
+
+static int _decode_lyrics(id3v2_frame *frame, id3v2_lyrics_content *content)
+{
+  char *cursor = frame->data + ID3V2_FRAME_ENCODING + ID3V2_FRAME_LANGUAGE;
+  char *end = frame->data + frame->size;
+
+  if(frame->size < ID3V2_FRAME_ENCODING + ID3V2_FRAME_LANGUAGE)
+    return 0;
+
+  content->language = frame->data + ID3V2_FRAME_ENCODING;
+  _read_text_view(&cursor, end, frame->data[0], &content->description);
+  _read_text_view(&cursor, end, frame->data[0], &content->text);
+
+  return 1;
+}
+
+static int _decode_synchronised_lyrics(id3v2_frame *frame, id3v2_synchronised_lyrics_content *content)
+{
+  char *cursor = frame->data + ID3V2_FRAME_ENCODING + ID3V2_FRAME_LANGUAGE + 2;
+  char *end = frame->data + frame->size;
+  id3v2_text_view line;
+  int count;
+  int i;
+
+  if(frame->size < ID3V2_FRAME_ENCODING + ID3V2_FRAME_LANGUAGE + 2)
+    return 0;
+
+  content->language = frame->data + ID3V2_FRAME_ENCODING;
+  content->timestamp_format = (unsigned char)frame->data[ID3V2_FRAME_ENCODING + ID3V2_FRAME_LANGUAGE];
+  content->content_type = (unsigned char)frame->data[ID3V2_FRAME_ENCODING + ID3V2_FRAME_LANGUAGE + 1];
+  _read_text_view(&cursor, end, frame->data[0], &content->description);
+  content->data = cursor;
+  content->size = (int)(end - cursor);
+
+  // counts the entries first, a line without its time stamp ends them
+  for(count = 0; cursor < end; count++)
+  {
+    _read_text_view(&cursor, end, frame->data[0], &line);
+    if(end - cursor < TIMESTAMP_SIZE)
+      break;
+    cursor += TIMESTAMP_SIZE;
+  }
+
+  content->timeline.timestamps = (uint32_t*)_allocate((count + 1) * sizeof(uint32_t));
+  content->lines = (id3v2_text_view*)_allocate((count + 1) * sizeof(id3v2_text_view));
+
+  if(content->timeline.timestamps == NULL || content->lines == NULL)
+    return 0;
+
+  for(cursor = content->data, i = 0; i < count; i++)
+  {
+    _read_text_view(&cursor, end, frame->data[0], &content->lines[i]);
+    content->timeline.timestamps[i] = btoi(cursor, TIMESTAMP_SIZE, 0);
+    cursor += TIMESTAMP_SIZE;
+  }
+
+  content->timeline.count = count;
+
+  return _sort_timeline(&content->timeline, (char*)content->lines, sizeof(id3v2_text_view));
+}
+
+static int _decode_event_timing(id3v2_frame *frame, id3v2_event_timing_content *content)
+{
+  int count = (frame->size - TIMESTAMP_FORMAT_SIZE) / EVENT_SIZE;
+  int i;
+
+  if(frame->size < TIMESTAMP_FORMAT_SIZE)
+    return 0;
+
+  content->timestamp_format = (unsigned char)frame->data[0];
+  content->timeline.timestamps = (uint32_t*)_allocate((count + 1) * sizeof(uint32_t));
+  content->events = (unsigned char*)_allocate(count + 1);
+
+  if(content->timeline.timestamps == NULL || content->events == NULL)
+    return 0;
+
+  for(i = 0; i < count; i++)
+  {
+    content->events[i] = (unsigned char)frame->data[TIMESTAMP_FORMAT_SIZE + i * EVENT_SIZE];
+    content->timeline.timestamps[i] = btoi(frame->data, TIMESTAMP_SIZE, TIMESTAMP_FORMAT_SIZE + i * EVENT_SIZE + 1);
+  }
+
+  content->timeline.count = count;
+
+  return _sort_timeline(&content->timeline, (char*)content->events, 1);
+}
+
+static int _decode_popularimeter(id3v2_frame *frame, id3v2_popularimeter_content *content)
+{
+  char *cursor = frame->data;
+  char *end = frame->data + frame->size;
+
+  _read_text_view(&cursor, end, ID3V2_ISO_ENCODING, &content->email);
+
+  if(cursor >= end)
+    return 0;
+
+  content->rating = (unsigned char)*cursor++;
+  content->counter = _read_counter(cursor, (int)(end - cursor));
+
+  return 1;
+}
+
+static int _decode_play_counter(id3v2_frame *frame, id3v2_play_counter_content *content)
+{
+  if(frame->size < 4)
+    return 0;
+
+  content->counter = _read_counter(frame->data, frame->size);
+
+  return 1;
+}
+
+// UFID and PRIV are both an owner followed by binary data
+static int _decode_owned_data(id3v2_frame *frame, id3v2_text_view *owner, char **data, int *size)
+{
+  char *cursor = frame->data;
+  char *end = frame->data + frame->size;
+
+  _read_text_view(&cursor, end, ID3V2_ISO_ENCODING, owner);
+  *data = cursor;
+  *size = (int)(end - cursor);
+
+  return 1;
+}
+
+static int _decode_general_object(id3v2_frame *frame, id3v2_general_object_content *content)
+{
+  char *cursor = frame->data + ID3V2_FRAME_ENCODING;
+  char *end = frame->data + frame->size;
+
+  if(frame->size < ID3V2_FRAME_ENCODING)
+    return 0;
+
+  _read_text_view(&cursor, end, ID3V2_ISO_ENCODING, &content->mime_type);
+  _read_text_view(&cursor, end, frame->data[0], &content->filename);
+  _read_text_view(&cursor, end, frame->data[0], &content->description);
+  content->object = cursor;
+  content->size = (int)(end - cursor);
+
+  return 1;
+}
+
+static int _decode_relative_volume(id3v2_frame *frame, id3v2_relative_volume_content *content)
+{
+  char *cursor = frame->data;
+  char *end = frame->data + frame->size;
+  id3v2_volume_channel *channel;
+  int peak_size;
+
+  _read_text_view(&cursor, end, ID3V2_ISO_ENCODING, &content->identification);
+  content->channel_count = 0;
+
+  while(end - cursor >= 4 && content->channel_count < ID3V2_VOLUME_CHANNELS)
+  {
+    channel = &content->channels[content->channel_count];
+    channel->type = (unsigned char)cursor[0];
+    channel->adjustment = (short)((unsigned char)cursor[1] << 8 | (unsigned char)cursor[2]);
+    channel->peak_bits = (unsigned char)cursor[3];
+    channel->peak = cursor + 4;
+
+    peak_size = (channel->peak_bits + 7) / 8;
+    if(peak_size > end - cursor - 4)
+      break;
+
+    cursor += 4 + peak_size;
+    content->channel_count++;
+  }
+
+  return 1;
+}
+
+// the timelines are the only contents which don't point into the frame
+static void _free_decoded_frame(id3v2_decoded_frame *decoded)
+{
+  if(decoded->kind == ID3V2_KIND_SYLT)
+  {
+    free(decoded->content.synchronised_lyrics.timeline.timestamps);
+    free(decoded->content.synchronised_lyrics.lines);
+  }
+  else if(decoded->kind == ID3V2_KIND_ETCO)
+  {
+    free(decoded->content.event_timing.timeline.timestamps);
+    free(decoded->content.event_timing.events);
+  }
+
+  free(decoded);
+}
+
+// decodes the frame as the given kind on the first call and returns the cached result on later ones
+static id3v2_decoded_frame *_decode_frame(id3v2_frame *frame, int kind)
+{
+  id3v2_decoded_frame *decoded;
+  int decoded_successfully = 0;
+
+  if(frame == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  if(frame->decoded != NULL && frame->decoded->kind == kind)
+  {
+    E_SUCCESS;
+    return frame->decoded;
+  }
+
+  if(frame->data == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_INSUFFICIENT_DATA);
+    return NULL;
+  }
+
+  id3v2_free_contents_of_frame(frame);
+
+  decoded = (id3v2_decoded_frame*)_allocate_zeroed(1, sizeof(id3v2_decoded_frame));
+
+  if(decoded == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  decoded->kind = kind;
+
+  switch(kind)
+  {
+    case ID3V2_KIND_TXXX:
+    case ID3V2_KIND_WXXX:
+      decoded_successfully = _decode_user_text(frame, &decoded->content.user_text, kind);
+      break;
+    case ID3V2_KIND_USLT:
+    case ID3V2_KIND_COMM:
+      decoded_successfully = _decode_lyrics(frame, &decoded->content.lyrics);
+      break;
+    case ID3V2_KIND_SYLT:
+      decoded_successfully = _decode_synchronised_lyrics(frame, &decoded->content.synchronised_lyrics);
+      break;
+    case ID3V2_KIND_ETCO:
+      decoded_successfully = _decode_event_timing(frame, &decoded->content.event_timing);
+      break;
+    case ID3V2_KIND_POPM:
+      decoded_successfully = _decode_popularimeter(frame, &decoded->content.popularimeter);
+      break;
+    case ID3V2_KIND_PCNT:
+      decoded_successfully = _decode_play_counter(frame, &decoded->content.play_counter);
+      break;
+    case ID3V2_KIND_UFID:
+      decoded_successfully = _decode_owned_data(frame, &decoded->content.unique_file_identifier.owner,
+                                                &decoded->content.unique_file_identifier.identifier,
+                                                &decoded->content.unique_file_identifier.size);
+      break;
+    case ID3V2_KIND_PRIV:
+      decoded_successfully = _decode_owned_data(frame, &decoded->content.private_data.owner,
+                                                &decoded->content.private_data.data,
+                                                &decoded->content.private_data.size);
+      break;
+    case ID3V2_KIND_GEOB:
+      decoded_successfully = _decode_general_object(frame, &decoded->content.general_object);
+      break;
+    case ID3V2_KIND_MCDI:
+      decoded->content.music_cd_identifier.table_of_contents = frame->data;
+      decoded->content.music_cd_identifier.size = frame->size;
+      decoded_successfully = 1;
+      break;
+    case ID3V2_KIND_RVA2:
+      decoded_successfully = _decode_relative_volume(frame, &decoded->content.relative_volume);
+      break;
+    default:
+      decoded_successfully = _decode_url(frame, &decoded->content.url);
+  }
+
+  if(!decoded_successfully)
+  {
+    _free_decoded_frame(decoded);
+    E_FAIL(ID3V2_ERROR_INSUFFICIENT_DATA);
+    return NULL;
+  }
+
+  frame->decoded = decoded;
+
+  E_SUCCESS;
+
+  return decoded;
+}
+
+// returns the cached content if the frame is one of the given kinds, NULL otherwise
+static id3v2_decoded_frame *_decode_frame_of_kind(id3v2_frame *frame, int kind, int other_kind)
+{
+  int frame_kind;
+
+  if(frame == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  frame_kind = _get_frame_kind_from_id(frame->id, frame->version);
+
+  if(frame_kind != kind && frame_kind != other_kind)
+  {
+    E_FAIL(ID3V2_ERROR_UNSUPPORTED);
+    return NULL;
+  }
+
+  return _decode_frame(frame, frame_kind);
+}
+
+// frees what the typed getters found, frames of tags do so on their own whenever their data goes away
+void id3v2_free_contents_of_frame(id3v2_frame *frame)
+{
+  if(frame == NULL || frame->decoded == NULL)
+    return;
+
+  _free_decoded_frame(frame->decoded);
+  frame->decoded = NULL;
+}
+
+id3v2_user_text_content *id3v2_get_user_text_content_from_frame(id3v2_frame *frame)
+{
+  id3v2_decoded_frame *decoded = _decode_frame_of_kind(frame, ID3V2_KIND_TXXX, ID3V2_KIND_WXXX);
+
+  return decoded != NULL ? &decoded->content.user_text : NULL;
+}
+
+id3v2_url_content *id3v2_get_url_content_from_frame(id3v2_frame *frame)
+{
+  id3v2_decoded_frame *decoded;
+  int frame_kind;
+
+  if(frame == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  frame_kind = _get_frame_kind_from_id(frame->id, frame->version);
+
+  // WXXX starts with a description, id3v2_get_user_text_content_from_frame() handles it
+  if(_get_frame_type_from_id(frame->id, frame->version) != ID3V2_URL_FRAME || frame_kind == ID3V2_KIND_WXXX)
+  {
+    E_FAIL(ID3V2_ERROR_UNSUPPORTED);
+    return NULL;
+  }
+
+  // links no version defines are decoded as ID3V2_UNKNOWN_KIND
+  decoded = _decode_frame(frame, frame_kind);
+
+  return decoded != NULL ? &decoded->content.url : NULL;
+}
+
+id3v2_lyrics_content *id3v2_get_lyrics_content_from_frame(id3v2_frame *frame)
+{
+  id3v2_decoded_frame *decoded = _decode_frame_of_kind(frame, ID3V2_KIND_USLT, ID3V2_KIND_COMM);
+
+  return decoded != NULL ? &decoded->content.lyrics : NULL;
+}
+
+id3v2_synchronised_lyrics_content *id3v2_get_synchronised_lyrics_content_from_frame(id3v2_frame *frame)
+{
+  id3v2_decoded_frame *decoded = _decode_frame_of_kind(frame, ID3V2_KIND_SYLT, ID3V2_KIND_SYLT);
+
+  return decoded != NULL ? &decoded->content.synchronised_lyrics : NULL;
+}
+
+id3v2_event_timing_content *id3v2_get_event_timing_content_from_frame(id3v2_frame *frame)
+{
+  id3v2_decoded_frame *decoded = _decode_frame_of_kind(frame, ID3V2_KIND_ETCO, ID3V2_KIND_ETCO);
+
+  return decoded != NULL ? &decoded->content.event_timing : NULL;
+}
+
+id3v2_popularimeter_content *id3v2_get_popularimeter_content_from_frame(id3v2_frame *frame)
+{
+  id3v2_decoded_frame *decoded = _decode_frame_of_kind(frame, ID3V2_KIND_POPM, ID3V2_KIND_POPM);
+
+  return decoded != NULL ? &decoded->content.popularimeter : NULL;
+}
+
+id3v2_play_counter_content *id3v2_get_play_counter_content_from_frame(id3v2_frame *frame)
+{
+  id3v2_decoded_frame *decoded = _decode_frame_of_kind(frame, ID3V2_KIND_PCNT, ID3V2_KIND_PCNT);
+
+  return decoded != NULL ? &decoded->content.play_counter : NULL;
+}
+
+id3v2_unique_file_identifier_content *id3v2_get_unique_file_identifier_content_from_frame(id3v2_frame *frame)
+{
+  id3v2_decoded_frame *decoded = _decode_frame_of_kind(frame, ID3V2_KIND_UFID, ID3V2_KIND_UFID);
+
+  return decoded != NULL ? &decoded->content.unique_file_identifier : NULL;
+}
+
+id3v2_private_content *id3v2_get_private_content_from_frame(id3v2_frame *frame)
+{
+  id3v2_decoded_frame *decoded = _decode_frame_of_kind(frame, ID3V2_KIND_PRIV, ID3V2_KIND_PRIV);
+
+  return decoded != NULL ? &decoded->content.private_data : NULL;
+}
+
+id3v2_general_object_content *id3v2_get_general_object_content_from_frame(id3v2_frame *frame)
+{
+  id3v2_decoded_frame *decoded = _decode_frame_of_kind(frame, ID3V2_KIND_GEOB, ID3V2_KIND_GEOB);
+
+  return decoded != NULL ? &decoded->content.general_object : NULL;
+}
+
+id3v2_music_cd_identifier_content *id3v2_get_music_cd_identifier_content_from_frame(id3v2_frame *frame)
+{
+  id3v2_decoded_frame *decoded = _decode_frame_of_kind(frame, ID3V2_KIND_MCDI, ID3V2_KIND_MCDI);
+
+  return decoded != NULL ? &decoded->content.music_cd_identifier : NULL;
+}
+
+id3v2_relative_volume_content *id3v2_get_relative_volume_content_from_frame(id3v2_frame *frame)
+{
+  id3v2_decoded_frame *decoded = _decode_frame_of_kind(frame, ID3V2_KIND_RVA2, ID3V2_KIND_RVA2);
+
+  return decoded != NULL ? &decoded->content.relative_volume : NULL;
+}
+
+// the picture type and description of APIC, the picture itself may sit in a cached image behind the data
+static int _read_picture_key(id3v2_frame *frame, char *picture_type, id3v2_text_view *description)
+{
+  char *cursor = frame->data + ID3V2_FRAME_ENCODING;
+  char *end = frame->data + frame->size;
+  id3v2_text_view mime_type;
+
+  if(frame->size < ID3V2_FRAME_ENCODING + ID3V2_DECIDE_FRAME(frame->version, 3, 0))
+    return 0;
+
+  // v2.2 has a format of 3 characters instead of the MIME type
+  if(frame->version == ID3V2_2)
+    cursor += 3;
+  else
+    _read_text_view(&cursor, end, ID3V2_ISO_ENCODING, &mime_type);
+
+  if(cursor >= end)
+    return 0;
+
+  *picture_type = *cursor++;
+  _read_text_view(&cursor, end, frame->data[0], description);
+
+  return 1;
+}
+
+// finds what the standard keeps unique among frames with the same ID, as described with id3v2_patch_operation,
+// allocated and in UTF-8. Frames without one or which can't be decoded get NULL, returns 0 if there's no memory for it
+int _get_unique_key_of_frame(id3v2_frame *frame, char **key, int *key_size)
+{
+  id3v2_user_text_content *user_text;
+  id3v2_lyrics_content *lyrics;
+  id3v2_synchronised_lyrics_content *synchronised_lyrics;
+  id3v2_private_content *private_data;
+  id3v2_unique_file_identifier_content *unique_file_identifier;
+  id3v2_popularimeter_content *popularimeter;
+  id3v2_general_object_content *general_object;
+  id3v2_text_view description;
+  id3v2_text_view *text = NULL;
+  char prefix[UNIQUE_KEY_PREFIX];
+  int prefix_size = 0;
+
+  *key = NULL;
+  *key_size = 0;
+
+  if(frame->data == NULL)
+    return 1;
+
+  switch(_get_frame_kind_from_id(frame->id, frame->version))
+  {
+    case ID3V2_KIND_TXXX:
+    case ID3V2_KIND_WXXX:
+      user_text = id3v2_get_user_text_content_from_frame(frame);
+      text = user_text != NULL ? &user_text->description : NULL;
+      break;
+    case ID3V2_KIND_COMM:
+    case ID3V2_KIND_USLT:
+      lyrics = id3v2_get_lyrics_content_from_frame(frame);
+      if(lyrics != NULL)
+      {
+        memcpy(prefix, lyrics->language, ID3V2_FRAME_LANGUAGE);
+        prefix_size = ID3V2_FRAME_LANGUAGE;
+        text = &lyrics->description;
+      }
+      break;
+    case ID3V2_KIND_SYLT:
+      synchronised_lyrics = id3v2_get_synchronised_lyrics_content_from_frame(frame);
+      if(synchronised_lyrics != NULL)
+      {
+        memcpy(prefix, synchronised_lyrics->language, ID3V2_FRAME_LANGUAGE);
+        prefix_size = ID3V2_FRAME_LANGUAGE;
+        text = &synchronised_lyrics->description;
+      }
+      break;
+    case ID3V2_KIND_PRIV:
+      private_data = id3v2_get_private_content_from_frame(frame);
+      text = private_data != NULL ? &private_data->owner : NULL;
+      break;
+    case ID3V2_KIND_UFID:
+      unique_file_identifier = id3v2_get_unique_file_identifier_content_from_frame(frame);
+      text = unique_file_identifier != NULL ? &unique_file_identifier->owner : NULL;
+      break;
+    case ID3V2_KIND_POPM:
+      popularimeter = id3v2_get_popularimeter_content_from_frame(frame);
+      text = popularimeter != NULL ? &popularimeter->email : NULL;
+      break;
+    case ID3V2_KIND_GEOB:
+      general_object = id3v2_get_general_object_content_from_frame(frame);
+      text = general_object != NULL ? &general_object->description : NULL;
+      break;
+    case ID3V2_KIND_APIC:
+      if(_read_picture_key(frame, prefix, &description))
+      {
+        prefix_size = 1;
+        text = &description;
+      }
+      break;
+  }
+
+  if(text == NULL)
+    return 1;
+
+  *key = (char*)_allocate(prefix_size + text->size * 2 + 1);
+
+  if(*key == NULL)
+    return 0;
+
+  memcpy(*key, prefix, prefix_size);
+  *key_size = prefix_size + _convert_text_to_utf8(text->text, text->size, text->encoding, *key + prefix_size);
+
+  return 1;
+}
@@ -9,7 +9,14 @@
 
 #include "id3v2lib.h"
 
+// every thread keeps its own error, so loads running in parallel don't overwrite each other's
+#if defined(_MSC_VER)
+__declspec(thread) unsigned short id3v2_error = ID3V2_OK;
+#elif defined(__GNUC__)
+__thread unsigned short id3v2_error = ID3V2_OK;
+#else
 unsigned short id3v2_error = ID3V2_OK;
+#endif
 
 unsigned short id3v2_get_error()
 {
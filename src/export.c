@@ -0,0 +1,522 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+// A column file starts with the magic "ID3COLS\0", the format version and the column count as 32 bit integers and
+// the row count as 64 bit integer. A directory entry per column follows:
+//   name         COLUMN_NAME bytes, padded with zeros
+//   type         one of the ID3V2_*_COLUMN constants as 32 bit integer
+//   entries      dictionary size as 32 bit integer, 0 for other columns
+//   buffers      COLUMN_BUFFERS pairs of offset and length as 64 bit integers, unused ones are zero
+// Integer columns have one buffer of 32 bit values. String columns have 32 bit offsets (row count + 1 of them,
+// like Arrow's utf8 layout) and the bytes they point into. Dictionary columns have a 32 bit dictionary index per
+// row, followed by the offsets and bytes of the dictionary. Every buffer starts at a multiple of 8 bytes and
+// all integers are little endian, so readers only touch the columns they need.
+// There is no validity buffer: a row without a value holds 0 in an integer column, an empty string in a string
+// column and the index -1 in a dictionary column. So a missing number reads the same as a stored 0, and a missing
+// string the same as an empty one; only dictionary columns tell them apart.
+#define COLUMN_MAGIC "ID3COLS"
+#define COLUMN_VERSION 1
+#define COLUMN_HEADER 24
+#define COLUMN_NAME 16
+#define COLUMN_BUFFERS 3
+#define COLUMN_ENTRY (COLUMN_NAME + 8 + COLUMN_BUFFERS * 16)
+#define COLUMN_ALIGNMENT 8
+#define COLUMN_DICTIONARY_SLOTS 64 // needs to be a power of two
+
+typedef struct
+{
+  char *data;
+  size_t size;
+  size_t capacity;
+} column_buffer;
+
+typedef struct
+{
+  char name[COLUMN_NAME];
+  char id[ID3V2_FRAME_ID + 1]; // for v2.3 and v2.4 tags
+  char id2[ID3V2_FRAME_ID2 + 1]; // for v2.2 tags, empty if the column has no v2.2 frame
+  char id4[ID3V2_FRAME_ID + 1]; // v2.4 replacement of id, empty if there is none
+  int type;
+  column_buffer values; // integers or dictionary indices, or the string offsets
+  column_buffer bytes; // string bytes, or the dictionary offsets
+  column_buffer dictionary; // dictionary bytes
+  int *slots; // open addressing index into the dictionary, -1 marks a free slot
+  int slot_count;
+  int entry_count;
+} export_column;
+
+struct id3v2_column_exporter
+{
+  export_column *columns;
+  int column_count;
+  int row_count;
+  id3v2_frame **found; // frame of each column in the row being added
+  char *text; // UTF-8 conversion scratch buffer
+  int text_size;
+};
+
+static int _append_to_column_buffer(column_buffer *buffer, const void *data, size_t size)
+{
+  char *resized;
+  size_t capacity;
+
+  if(buffer->size + size > buffer->capacity)
+  {
+    capacity = buffer->capacity > 0 ? buffer->capacity : 256;
+    while(capacity < buffer->size + size)
+      capacity *= 2;
+
+    resized = (char*)_reallocate(buffer->data, capacity);
+
+    if(resized == NULL)
+      return 0;
+
+    buffer->data = resized;
+    buffer->capacity = capacity;
+  }
+
+  if(size > 0)
+    memcpy(buffer->data + buffer->size, data, size);
+  buffer->size += size;
+
+  return 1;
+}
+
+static int _append_integer_to_column_buffer(column_buffer *buffer, int value)
+{
+  char bytes[4];
+
+  _write_little_endian_to_buffer(bytes, (uint64_t)(uint32_t)value, 4);
+
+  return _append_to_column_buffer(buffer, bytes, 4);
+}
+
+static int _add_column(id3v2_column_exporter *exporter, const char *name, const char *id, const char *id2, const char *id4, int type)
+{
+  export_column *columns;
+  export_column *column;
+  id3v2_frame **found;
+  int i;
+
+  columns = (export_column*)_reallocate(exporter->columns, (exporter->column_count + 1) * sizeof(export_column));
+  if(columns == NULL)
+    return 0;
+  exporter->columns = columns;
+
+  found = (id3v2_frame**)_reallocate(exporter->found, (exporter->column_count + 1) * sizeof(id3v2_frame*));
+  if(found == NULL)
+    return 0;
+  exporter->found = found;
+
+  column = &exporter->columns[exporter->column_count];
+  memset(column, 0, sizeof(export_column));
+  strncpy(column->name, name, COLUMN_NAME - 1);
+  strncpy(column->id, id, ID3V2_FRAME_ID);
+  strncpy(column->id2, id2, ID3V2_FRAME_ID2);
+  strncpy(column->id4, id4, ID3V2_FRAME_ID);
+  column->type = type;
+
+  if(type == ID3V2_DICTIONARY_COLUMN)
+  {
+    column->slots = (int*)_allocate(COLUMN_DICTIONARY_SLOTS * sizeof(int));
+    if(column->slots == NULL)
+      return 0;
+    for(i = 0; i < COLUMN_DICTIONARY_SLOTS; i++)
+      column->slots[i] = -1;
+    column->slot_count = COLUMN_DICTIONARY_SLOTS;
+  }
+
+  // strings and the dictionary start with the offset of their first entry
+  if((type == ID3V2_STRING_COLUMN && !_append_integer_to_column_buffer(&column->values, 0)) ||
+     (type == ID3V2_DICTIONARY_COLUMN && !_append_integer_to_column_buffer(&column->bytes, 0)))
+  {
+    free(column->slots);
+    return 0;
+  }
+
+  exporter->column_count++;
+
+  return 1;
+}
+
+static void _free_column(export_column *column)
+{
+  free(column->values.data);
+  free(column->bytes.data);
+  free(column->dictionary.data);
+  free(column->slots);
+}
+
+// the exporter starts out with the common fields, id3v2_add_column_to_column_exporter adds more
+id3v2_column_exporter *id3v2_new_column_exporter()
+{
+  id3v2_column_exporter *exporter = (id3v2_column_exporter*)_allocate_zeroed(1, sizeof(id3v2_column_exporter));
+
+  if(exporter == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  if(!_add_column(exporter, "title", "TIT2", "TT2", "", ID3V2_STRING_COLUMN) ||
+     !_add_column(exporter, "artist", "TPE1", "TP1", "", ID3V2_STRING_COLUMN) ||
+     !_add_column(exporter, "album", "TALB", "TAL", "", ID3V2_STRING_COLUMN) ||
+     !_add_column(exporter, "album_artist", "TPE2", "TP2", "", ID3V2_STRING_COLUMN) ||
+     !_add_column(exporter, "composer", "TCOM", "TCM", "", ID3V2_STRING_COLUMN) ||
+     !_add_column(exporter, "genre", "TCON", "TCO", "", ID3V2_DICTIONARY_COLUMN) ||
+     !_add_column(exporter, "year", "TYER", "TYE", "TDRC", ID3V2_INTEGER_COLUMN) ||
+     !_add_column(exporter, "track", "TRCK", "TRK", "", ID3V2_INTEGER_COLUMN) ||
+     !_add_column(exporter, "disc", "TPOS", "TPA", "", ID3V2_INTEGER_COLUMN))
+  {
+    id3v2_free_column_exporter(exporter);
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  E_SUCCESS;
+
+  return exporter;
+}
+
+void id3v2_free_column_exporter(id3v2_column_exporter *exporter)
+{
+  int i;
+
+  if(exporter == NULL)
+    return;
+
+  for(i = 0; i < exporter->column_count; i++)
+    _free_column(&exporter->columns[i]);
+
+  free(exporter->columns);
+  free(exporter->found);
+  free(exporter->text);
+  free(exporter);
+}
+
+// adds a column filled from the text frame with the id, only possible before the first row got added
+// frame ids of 3 characters are looked up in v2.2 tags, the others in v2.3 and v2.4 tags
+int id3v2_add_column_to_column_exporter(id3v2_column_exporter *exporter, const char *name, const char *frame_id, int type)
+{
+  if(exporter == NULL || name == NULL || frame_id == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  if(exporter->row_count > 0 || strlen(name) >= COLUMN_NAME ||
+     (strlen(frame_id) != ID3V2_FRAME_ID && strlen(frame_id) != ID3V2_FRAME_ID2) ||
+     (type != ID3V2_STRING_COLUMN && type != ID3V2_INTEGER_COLUMN && type != ID3V2_DICTIONARY_COLUMN))
+  {
+    E_FAIL(ID3V2_ERROR_UNSUPPORTED);
+    return 0;
+  }
+
+  if(!_add_column(exporter, name, strlen(frame_id) == ID3V2_FRAME_ID ? frame_id : "",
+                  strlen(frame_id) == ID3V2_FRAME_ID2 ? frame_id : "", "", type))
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return 0;
+  }
+
+  E_SUCCESS;
+
+  return 1;
+}
+
+int id3v2_get_row_count_from_column_exporter(id3v2_column_exporter *exporter)
+{
+  if(exporter == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  E_SUCCESS;
+
+  return exporter->row_count;
+}
+
+// returns the UTF-8 text of the frame in the scratch buffer of the exporter, -1 on failure
+static int _get_utf8_text_from_frame(id3v2_column_exporter *exporter, id3v2_frame *frame, char **utf8)
+{
+  char encoding;
+  char *resized;
+  int size;
+  char *text;
+
+  if(frame->size <= ID3V2_FRAME_ENCODING)
+  {
+    *utf8 = (char*)"";
+    return 0;
+  }
+
+  encoding = frame->data[0];
+  text = frame->data + ID3V2_FRAME_ENCODING;
+  size = frame->size - ID3V2_FRAME_ENCODING;
+
+  if(size * 2 > exporter->text_size)
+  {
+    resized = (char*)_reallocate(exporter->text, size * 2);
+    if(resized == NULL)
+      return -1;
+    exporter->text = resized;
+    exporter->text_size = size * 2;
+  }
+
+  *utf8 = exporter->text;
+
+  return _convert_text_to_utf8(text, size, encoding, exporter->text);
+}
+
+// returns the index of the value in the dictionary of the column, adding it if it is new
+static int _get_dictionary_index(export_column *column, const char *value, int size)
+{
+  int end;
+  int i;
+  int index;
+  int *slots;
+  int slot;
+  int start;
+
+  if((column->entry_count + 1) * 2 > column->slot_count)
+  {
+    slots = (int*)_allocate(column->slot_count * 2 * sizeof(int));
+    if(slots == NULL)
+      return -1;
+    for(i = 0; i < column->slot_count * 2; i++)
+      slots[i] = -1;
+
+    for(i = 0; i < column->slot_count; i++)
+    {
+      if(column->slots[i] < 0)
+        continue;
+
+      start = (int)_read_little_endian_from_buffer(column->bytes.data + column->slots[i] * 4, 4);
+      end = (int)_read_little_endian_from_buffer(column->bytes.data + (column->slots[i] + 1) * 4, 4);
+      slot = (int)(_xxhash64_buffer(column->dictionary.data + start, end - start, 0) & (column->slot_count * 2 - 1));
+
+      while(slots[slot] >= 0)
+        slot = (slot + 1) & (column->slot_count * 2 - 1);
+      slots[slot] = column->slots[i];
+    }
+
+    free(column->slots);
+    column->slots = slots;
+    column->slot_count *= 2;
+  }
+
+  slot = (int)(_xxhash64_buffer(value, size, 0) & (column->slot_count - 1));
+
+  while((index = column->slots[slot]) >= 0)
+  {
+    start = (int)_read_little_endian_from_buffer(column->bytes.data + index * 4, 4);
+    end = (int)_read_little_endian_from_buffer(column->bytes.data + (index + 1) * 4, 4);
+
+    if(end - start == size && memcmp(column->dictionary.data + start, value, size) == 0)
+      return index;
+
+    slot = (slot + 1) & (column->slot_count - 1);
+  }
+
+  // dictionary offsets are 32 bit like the string offsets
+  if(column->dictionary.size + size > 0x7FFFFFFF)
+    return -1;
+
+  if(!_append_to_column_buffer(&column->dictionary, value, size) ||
+     !_append_integer_to_column_buffer(&column->bytes, (int)column->dictionary.size))
+    return -1;
+
+  column->slots[slot] = column->entry_count;
+
+  return column->entry_count++;
+}
+
+static int _parse_leading_number(const char *text, int size)
+{
+  int i = 0;
+  int value = 0;
+
+  while(i < size && text[i] == ' ')
+    i++;
+
+  for(; i < size && text[i] >= '0' && text[i] <= '9' && value < 100000000; i++)
+    value = value * 10 + (text[i] - '0');
+
+  return value;
+}
+
+static int _append_frame_to_column(id3v2_column_exporter *exporter, export_column *column, id3v2_frame *frame)
+{
+  int index = -1;
+  int size = 0;
+  char *utf8 = NULL;
+
+  if(frame != NULL && (size = _get_utf8_text_from_frame(exporter, frame, &utf8)) < 0)
+    return 0;
+
+  switch(column->type)
+  {
+    case ID3V2_INTEGER_COLUMN:
+      return _append_integer_to_column_buffer(&column->values, frame != NULL ? _parse_leading_number(utf8, size) : 0);
+    case ID3V2_DICTIONARY_COLUMN:
+      if(frame != NULL && (index = _get_dictionary_index(column, utf8, size)) < 0)
+        return 0;
+      return _append_integer_to_column_buffer(&column->values, index);
+    default:
+      // offsets are 32 bit like in Arrow's utf8 layout
+      if(column->bytes.size + size > 0x7FFFFFFF)
+        return 0;
+      return _append_to_column_buffer(&column->bytes, utf8, size) &&
+             _append_integer_to_column_buffer(&column->values, (int)column->bytes.size);
+  }
+}
+
+// appends a row with the fields of the tag, a NULL tag adds a row of missing values
+// the first frame with the id of a column fills it, frames other than text frames are ignored
+int id3v2_add_tag_to_column_exporter(id3v2_column_exporter *exporter, id3v2_tag *tag)
+{
+  export_column *column;
+  id3v2_frame *frame;
+  int i;
+
+  if(exporter == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  memset(exporter->found, 0, exporter->column_count * sizeof(id3v2_frame*));
+
+  for(frame = tag != NULL ? tag->frame : NULL; frame != NULL; frame = frame->next)
+  {
+    if(frame->id[0] != 'T' || frame->data == NULL)
+      continue;
+
+    for(i = 0; i < exporter->column_count; i++)
+    {
+      column = &exporter->columns[i];
+
+      if(exporter->found[i] != NULL)
+        continue;
+
+      if(frame->version == ID3V2_2 ? (column->id2[0] != '\0' && memcmp(frame->id, column->id2, ID3V2_FRAME_ID2) == 0)
+                                   : ((column->id[0] != '\0' && memcmp(frame->id, column->id, ID3V2_FRAME_ID) == 0) ||
+                                      (column->id4[0] != '\0' && memcmp(frame->id, column->id4, ID3V2_FRAME_ID) == 0)))
+        exporter->found[i] = frame;
+    }
+  }
+
+  for(i = 0; i < exporter->column_count; i++)
+  {
+    if(!_append_frame_to_column(exporter, &exporter->columns[i], exporter->found[i]))
+    {
+      E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+      return 0;
+    }
+  }
+
+  exporter->row_count++;
+
+  E_SUCCESS;
+
+  return 1;
+}
+
+static int _write_column_buffer(column_buffer *buffer, FILE *file)
+{
+  static const char padding[COLUMN_ALIGNMENT] = { 0 };
+  size_t padded = (buffer->size + COLUMN_ALIGNMENT - 1) & ~(size_t)(COLUMN_ALIGNMENT - 1);
+
+  return (buffer->size == 0 || fwrite(buffer->data, 1, buffer->size, file) == buffer->size) &&
+         (padded == buffer->size || fwrite(padding, 1, padded - buffer->size, file) == padded - buffer->size);
+}
+
+// writes the rows added so far as column file at the current position of the file, returns 0 on failure
+int id3v2_write_column_exporter_to_file(id3v2_column_exporter *exporter, FILE *file)
+{
+  column_buffer *buffers[COLUMN_BUFFERS];
+  export_column *column;
+  char entry[COLUMN_ENTRY];
+  int i;
+  int j;
+  uint64_t offset;
+
+  if(exporter == NULL || file == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  memset(entry, 0, sizeof(entry));
+  memcpy(entry, COLUMN_MAGIC, sizeof(COLUMN_MAGIC));
+  _write_little_endian_to_buffer(entry + 8, COLUMN_VERSION, 4);
+  _write_little_endian_to_buffer(entry + 12, (uint64_t)exporter->column_count, 4);
+  _write_little_endian_to_buffer(entry + 16, (uint64_t)exporter->row_count, 8);
+
+  if(fwrite(entry, 1, COLUMN_HEADER, file) != COLUMN_HEADER)
+  {
+    E_FAIL(ID3V2_ERROR_IO);
+    return 0;
+  }
+
+  offset = COLUMN_HEADER + (uint64_t)exporter->column_count * COLUMN_ENTRY;
+
+  for(i = 0; i < exporter->column_count; i++)
+  {
+    column = &exporter->columns[i];
+    buffers[0] = &column->values;
+    buffers[1] = column->type == ID3V2_INTEGER_COLUMN ? NULL : &column->bytes;
+    buffers[2] = column->type == ID3V2_DICTIONARY_COLUMN ? &column->dictionary : NULL;
+
+    memset(entry, 0, sizeof(entry));
+    memcpy(entry, column->name, COLUMN_NAME);
+    _write_little_endian_to_buffer(entry + COLUMN_NAME, (uint64_t)column->type, 4);
+    _write_little_endian_to_buffer(entry + COLUMN_NAME + 4, (uint64_t)column->entry_count, 4);
+
+    for(j = 0; j < COLUMN_BUFFERS; j++)
+    {
+      if(buffers[j] == NULL)
+        continue;
+
+      _write_little_endian_to_buffer(entry + COLUMN_NAME + 8 + j * 16, offset, 8);
+      _write_little_endian_to_buffer(entry + COLUMN_NAME + 16 + j * 16, (uint64_t)buffers[j]->size, 8);
+      offset += (buffers[j]->size + COLUMN_ALIGNMENT - 1) & ~(size_t)(COLUMN_ALIGNMENT - 1);
+    }
+
+    if(fwrite(entry, 1, COLUMN_ENTRY, file) != COLUMN_ENTRY)
+    {
+      E_FAIL(ID3V2_ERROR_IO);
+      return 0;
+    }
+  }
+
+  for(i = 0; i < exporter->column_count; i++)
+  {
+    column = &exporter->columns[i];
+
+    if(!_write_column_buffer(&column->values, file) ||
+       (column->type != ID3V2_INTEGER_COLUMN && !_write_column_buffer(&column->bytes, file)) ||
+       (column->type == ID3V2_DICTIONARY_COLUMN && !_write_column_buffer(&column->dictionary, file)))
+    {
+      E_FAIL(ID3V2_ERROR_IO);
+      return 0;
+    }
+  }
+
+  E_SUCCESS;
+
+  return 1;
+}
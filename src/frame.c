@@ -10,57 +10,43 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
 
 #include "id3v2lib.h"
 
-id3v2_frame* _parse_frame_from_tag(id3v2_tag *tag, char *bytes)
+// length is what's left of the tag, frames which claim more than that are treated as the end of the frames
+id3v2_frame* _parse_frame_from_tag(id3v2_tag *tag, char *bytes, int length)
 {
-    id3v2_frame* frame = id3v2_new_frame(tag, ID3V2_UNDEFINED_FRAME);
+    id3v2_frame* frame;
     int offset = 0;
+    int size;
     int version = id3v2_get_tag_version(tag);
-    
+    int header_size = ID3V2_DECIDE_FRAME(version, ID3V2_FRAME_ID2 + ID3V2_FRAME_SIZE2, ID3V2_FRAME);
+
+    // padding or garbage, both end the frames
+    if(length < header_size || !_is_valid_frame_id(bytes, version))
+      return NULL;
+
+    size = btoi(bytes, ID3V2_DECIDE_FRAME(version, ID3V2_FRAME_SIZE2, ID3V2_FRAME_SIZE), ID3V2_DECIDE_FRAME(version, ID3V2_FRAME_ID2, ID3V2_FRAME_ID));
+    if(version == ID3V2_4)
+        size = syncint_decode(size);
+
+    if(size < 0 || size > length - header_size)
+      return NULL;
+
+    frame = id3v2_new_frame(tag, ID3V2_UNDEFINED_FRAME);
+
     if(frame == NULL)
       return NULL;
 
     // Parse frame header
-    memcpy(frame->id, bytes + offset, ID3V2_DECIDE_FRAME(version, ID3V2_FRAME_SIZE2, ID3V2_FRAME_ID));
+    memcpy(frame->id, bytes, ID3V2_DECIDE_FRAME(version, ID3V2_FRAME_ID2, ID3V2_FRAME_ID));
 
     if(version==ID3V2_2)
       // fill the remaining space with emptyness
       frame->id[3]='\0';
 
-    // Check if we are into padding
-    if(memcmp(frame->id, "\0\0\0", 3) == 0)
-    {
-        free(frame);
-        return NULL;
-    }
-
-    // check if all relevant chars are alphabetical
-    if(version == ID3V2_2 && (
-       !isalpha(frame->id[0]) ||
-       !isalpha(frame->id[1]) ||
-       !isalnum(frame->id[2])))
-    {
-      free(frame);
-      return NULL;
-    }
-    else if(version != ID3V2_2 && (
-            !isalpha(frame->id[0]) ||
-            !isalpha(frame->id[1]) ||
-            !isalpha(frame->id[2]) ||
-            !isalnum(frame->id[3])))
-    {
-      free(frame);
-      return NULL;
-    }
-
-    frame->size = btoi(bytes, ID3V2_DECIDE_FRAME(version, ID3V2_FRAME_SIZE2, ID3V2_FRAME_SIZE), offset += ID3V2_DECIDE_FRAME(version, ID3V2_FRAME_ID2, ID3V2_FRAME_ID));
-    if(version == ID3V2_4)
-    {
-        frame->size = syncint_decode(frame->size);
-    }
+    frame->size = size;
+    offset += ID3V2_DECIDE_FRAME(version, ID3V2_FRAME_ID2, ID3V2_FRAME_ID);
 
     if(version != ID3V2_2) // flags are only available in v23 and 24 tags
     {
@@ -68,9 +54,9 @@ id3v2_frame* _parse_frame_from_tag(id3v2_tag *tag, char *bytes)
       offset += ID3V2_FRAME_FLAGS;
 
       // if some unknown flags are set, we ignore this frame since that actually means that the frame might not be parseable
-      if(frame->flags[1]&(1<<7)==(1<<7) ||
-         frame->flags[1]&(1<<5)==(1<<5) ||
-         frame->flags[1]&(1<<4)==(1<<4))
+      if((frame->flags[1]&(1<<7))==(1<<7) ||
+         (frame->flags[1]&(1<<5))==(1<<5) ||
+         (frame->flags[1]&(1<<4))==(1<<4))
       {
         frame->parsed = 0;
         return frame;
@@ -83,7 +69,7 @@ id3v2_frame* _parse_frame_from_tag(id3v2_tag *tag, char *bytes)
     free(frame->data);
 
     // Load frame data
-    frame->data= (char *)malloc(frame->size * sizeof(char));
+    frame->data= (char *)_allocate(frame->size * sizeof(char));
 
     if(frame->data == NULL)
     {
@@ -106,25 +92,7 @@ int id3v2_get_frame_type(id3v2_frame *frame)
 
     E_SUCCESS;
 
-    // some exceptions, for example...
-    if(strcmp(frame->id, "PIC\0")==0) // not called APIC in v22, but PIC instead
-      return ID3V2_APIC_FRAME;
-
-    switch(frame->id[0])
-    {
-        case 'T':
-            return ID3V2_TEXT_FRAME;
-        case 'C':
-            return ID3V2_COMMENT_FRAME;
-        case 'A':
-            return ID3V2_APIC_FRAME;
-        case 'X':
-        case 'Y':
-        case 'Z':
-            return ID3V2_EXPERIMENTAL_FRAME;
-        default:
-            return ID3V2_INVALID_FRAME;
-    }
+    return _get_frame_type_from_id(frame->id, frame->version);
 }
 
 void id3v2_add_frame_to_tag(id3v2_tag *tag, id3v2_frame *frame)
@@ -138,6 +106,8 @@ void id3v2_add_frame_to_tag(id3v2_tag *tag, id3v2_frame *frame)
     return;
   }
 
+  _free_frame_index_of_tag(tag);
+
   if(tag->frame == NULL)
   {
     tag->frame = frame;
@@ -152,6 +122,29 @@ void id3v2_add_frame_to_tag(id3v2_tag *tag, id3v2_frame *frame)
 
 }
 
+void _detach_frame_from_tag(id3v2_tag *tag, id3v2_frame *frame)
+{
+  id3v2_frame *previous_frame;
+
+  _free_frame_index_of_tag(tag);
+
+  if(tag->frame == frame)
+  {
+    tag->frame = frame->next;
+    frame->next = NULL;
+    return;
+  }
+
+  previous_frame = tag->frame;
+  while(previous_frame != NULL && previous_frame->next != frame)
+    previous_frame = previous_frame->next;
+
+  if(previous_frame != NULL)
+    previous_frame->next = frame->next;
+
+  frame->next = NULL;
+}
+
 id3v2_frame *id3v2_get_frame_from_tag(id3v2_tag *tag, char *frame_id)
 {
   char tmp_id[ID3V2_FRAME_ID];
@@ -189,55 +182,61 @@ id3v2_frame *id3v2_get_frame_from_tag(id3v2_tag *tag, char *frame_id)
   return matching_frame;
 }
 
-void _synchronize_frame(id3v2_frame *frame)
+// drops the zero bytes the unsynchronization inserted behind 0xFF, in place, and returns the new size
+static int _remove_unsynchronization(char *data, int size, char *pending_ff)
 {
-  char check = 0; // indicated we'll have to inspect the next 2 bytes carefully
   int i;
-  int sync_size = 0; // size of the synchronized data stream
-  // at first allocating as much space as given into this function, if less is used we'll re-allocate later
-  char *sync_data=(char *)malloc(frame->size * sizeof(char));
- 
-  if(sync_data==NULL)
-    return;
+  int sync_size = 0;
 
-  for(i = 0; i < frame->size; i++)
+  for(i = 0; i < size; i++)
   {
-    switch(check)
+    if(*pending_ff && data[i] == 0x00)
     {
-      case 0:
-        // check if we find the relevant syncbyte here
-        if(frame->data[i]==0xFF)
-          check = 1;
-        sync_data[sync_size++] = frame->data[i];
-        break;
-      case 1:
-        if(frame->data[i]!=0x00) // false alarm
-        {
-          check = 0;
-          sync_data[sync_size++] = frame->data[i];
-        }
-        else // inspect even more
-          check++;
-        break;
-      case 2:
-        if(frame->data[i]!=0x00 && frame->data[i]&(111<<7)!=(111<<7))
-        // false alarm, so we have to copy the previous byte at next and reset everything
-          sync_data[sync_size++] = frame->data[i-1];
-        sync_data[sync_size++] = frame->data[i];
-        check = 0;
-        break;
+      // this is an inserted zero byte, drop it
+      *pending_ff = 0;
+      continue;
     }
-  }  
-  // if we successfully synchronized something, we can re-allocate some stuff here
-  if(sync_size<frame->size)
-  {
-    sync_data = (char *)realloc(sync_data, sync_size);
-    if(sync_data == NULL)
-      return;
-    free(frame->data);
-    frame->data = sync_data;
-    frame->size = sync_size;
+    *pending_ff = ((unsigned char)data[i] == 0xFF);
+    data[sync_size++] = data[i];
   }
+
+  return sync_size;
+}
+
+// reverses the unsynchronization of the data of a frame in place
+void _synchronize_frame(id3v2_frame *frame)
+{
+  char pending_ff = 0;
+  int sync_size;
+  int64_t timer;
+
+  STATS_START_TIMER(timer);
+
+  sync_size = _remove_unsynchronization(frame->data, frame->size, &pending_ff);
+
+  STATS_ADD(unsynchronisation_bytes_removed, frame->size - sync_size);
+  STATS_STOP_TIMER(unsynchronisation_nanoseconds, timer);
+  TRACE(unsynchronisation, ID3V2_TRACE_UNSYNCHRONISATION, -1, frame->size, sync_size, frame->id, -1, -1);
+
+  frame->size = sync_size;
+}
+
+// reverses the unsynchronization of a buffer in place and returns the new size
+// pending_ff carries a trailing 0xFF over to the next chunk when decoding streams piece by piece
+int _synchronize_buffer(char *data, int size, char *pending_ff)
+{
+  int sync_size;
+  int64_t timer;
+
+  STATS_START_TIMER(timer);
+
+  sync_size = _remove_unsynchronization(data, size, pending_ff);
+
+  STATS_ADD(unsynchronisation_bytes_removed, size - sync_size);
+  STATS_STOP_TIMER(unsynchronisation_nanoseconds, timer);
+  TRACE(unsynchronisation, ID3V2_TRACE_UNSYNCHRONISATION, -1, size, sync_size, NULL, -1, -1);
+
+  return sync_size;
 }
 
 void id3v2_get_text_from_frame(id3v2_frame *frame, char **text, int *size, char *encoding)
@@ -350,7 +349,6 @@ void id3v2_get_picture_from_frame(id3v2_frame *frame, char **picture, int *size,
   char *description;
   int description_size;
   char encoding;
-  char *mime_type_buffer;
 
   if(frame == NULL)
   {
@@ -366,32 +364,22 @@ void id3v2_get_picture_from_frame(id3v2_frame *frame, char **picture, int *size,
 
   id3v2_get_text_from_frame(frame, &description, &description_size, &encoding);
 
-  *picture = description + description_size;
+  if(frame->image != NULL)
+    _get_picture_from_cached_image(frame->image, picture, size);
+  else
+  {
+    *picture = description + description_size;
 
-  *size = (frame->data + frame->size) - (*picture);
+    *size = (frame->data + frame->size) - (*picture);
+  }
 
+  // v2.2 only names the image format, its mime type is one of the constants then, so frames without a tag work too
   if(frame->version == ID3V2_2)
   {
     if(memcmp(frame->data + ID3V2_FRAME_ENCODING, ID3V2_JPG_MIME_TYPE2, 3)==0)
-      mime_type_buffer=(char*)malloc((strlen(ID3V2_JPG_MIME_TYPE)+1)*sizeof(char));
-    else
-      mime_type_buffer=(char*)malloc((strlen(ID3V2_PNG_MIME_TYPE)+1)*sizeof(char));
-    if(mime_type_buffer == NULL)
-    {
-      E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
-      *size = 0;
-      return;
-    }
-    if(_add_allocation_to_tag(frame->tag, mime_type_buffer)==0)
-    {
-      E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
-      return;
-    }
-    if(memcmp(frame->data + ID3V2_FRAME_ENCODING, ID3V2_JPG_MIME_TYPE2, 3)==0)
-      memcpy(mime_type_buffer, ID3V2_JPG_MIME_TYPE, strlen(ID3V2_JPG_MIME_TYPE)+1);
+      *mime_type = (char*)ID3V2_JPG_MIME_TYPE;
     else
-      memcpy(mime_type_buffer, ID3V2_PNG_MIME_TYPE, strlen(ID3V2_PNG_MIME_TYPE)+1);
-    *mime_type = mime_type_buffer;
+      *mime_type = (char*)ID3V2_PNG_MIME_TYPE;
   }
   else
     *mime_type = frame->data + ID3V2_FRAME_ENCODING;
@@ -430,7 +418,7 @@ void id3v2_initialize_frame(id3v2_frame *frame, int type)
     case ID3V2_UNDEFINED_FRAME:
       size = ID3V2_FRAME_ENCODING + 1;
       memset(frame->id, '\0', ID3V2_FRAME_ID);
-      data=(char*)malloc(size*sizeof(char));
+      data=(char*)_allocate(size*sizeof(char));
       if(data == NULL)
       {
         E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
@@ -441,7 +429,7 @@ void id3v2_initialize_frame(id3v2_frame *frame, int type)
     case ID3V2_TEXT_FRAME:
       frame->id[0] = 'T';
       size = ID3V2_FRAME_ENCODING + 1;
-      data=(char*)malloc(size*sizeof(char));
+      data=(char*)_allocate(size*sizeof(char));
       if(data == NULL)
       {
         E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
@@ -452,7 +440,7 @@ void id3v2_initialize_frame(id3v2_frame *frame, int type)
     case ID3V2_COMMENT_FRAME:
       frame->id[0] = 'C';
       size = ID3V2_FRAME_ENCODING + ID3V2_FRAME_LANGUAGE +2;
-      data=(char*)malloc(size*sizeof(char));
+      data=(char*)_allocate(size*sizeof(char));
       if(data == NULL)
       {
         E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
@@ -465,7 +453,7 @@ void id3v2_initialize_frame(id3v2_frame *frame, int type)
     case ID3V2_APIC_FRAME:
       memcpy(frame->id, ID3V2_GET_ALBUM_COVER_FRAME_ID_FROM_TAG(frame->tag), ID3V2_DECIDE_FRAME(frame->version, ID3V2_FRAME_ID2, ID3V2_FRAME_ID));
       size = ID3V2_FRAME_ENCODING + ID3V2_DECIDE_FRAME(frame->version, 3, 10) +3;
-      data=(char*)malloc(size*sizeof(char));
+      data=(char*)_allocate(size*sizeof(char));
       if(data == NULL)
       {
         E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
@@ -480,8 +468,7 @@ void id3v2_initialize_frame(id3v2_frame *frame, int type)
       return;
   }
 
-  if(frame->data != NULL)
-    free(frame->data);
+  _release_frame_data(frame);
 
   frame->size = size;
   frame->data = data;
@@ -526,12 +513,13 @@ void id3v2_set_text_to_frame(id3v2_frame *frame, char *text, int size, char enco
   {
     case ID3V2_TEXT_FRAME:
       f_size = size + ID3V2_FRAME_ENCODING;
-      data=(char*)malloc(f_size*sizeof(char));
+      data=(char*)_allocate(f_size*sizeof(char));
       if(data == NULL)
       {
         E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
         return;
       }
+      data[0] = encoding;
       memcpy(data+ID3V2_FRAME_ENCODING, text, size);
       break;
     case ID3V2_COMMENT_FRAME:
@@ -542,7 +530,7 @@ void id3v2_set_text_to_frame(id3v2_frame *frame, char *text, int size, char enco
         f_size += 2;
       else
         f_size++;
-      data=(char*)malloc(f_size * sizeof(char));
+      data=(char*)_allocate(f_size * sizeof(char));
       if(data == NULL)
       {
         E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
@@ -596,11 +584,14 @@ void id3v2_set_text_to_frame(id3v2_frame *frame, char *text, int size, char enco
       memcpy(data+(f_size-size), text, size);
       break;
     case ID3V2_APIC_FRAME:
+      // the picture gets copied over, so it has to be part of the frame data
+      if(!_own_frame_data(frame))
+        return;
       id3v2_get_text_from_frame(frame, &original_text, &original_size, &original_encoding);
       if(E_GET != ID3V2_OK)
         return;
-      f_size = ID3V2_FRAME_ENCODING + (original_text - frame->data) + ((frame->data + frame->size) - (original_text + original_size));
-      data=(char*)malloc(f_size * sizeof(char));
+      f_size = (original_text - frame->data) + size + ((frame->data + frame->size) - (original_text + original_size));
+      data=(char*)_allocate(f_size * sizeof(char));
       if(data == NULL)
       {
         E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
@@ -617,8 +608,7 @@ void id3v2_set_text_to_frame(id3v2_frame *frame, char *text, int size, char enco
   }
 
   frame->size = f_size;
-  if(frame->data != NULL)
-    free(frame->data);
+  _release_frame_data(frame);
 
   frame->data = data;
 
@@ -640,6 +630,9 @@ void id3v2_set_language_to_frame(id3v2_frame *frame, char *language)
     return;
   }
 
+  if(!_own_frame_data(frame))
+    return;
+
   memcpy(frame->data+ID3V2_FRAME_ENCODING, language, 3);
 
   E_SUCCESS;
@@ -655,6 +648,9 @@ void id3v2_set_id_to_frame(id3v2_frame *frame, char *id)
 
   memcpy(frame->id, id, ID3V2_DECIDE_FRAME(frame->version, ID3V2_FRAME_ID2, ID3V2_FRAME_ID));
 
+  if(frame->tag != NULL)
+    _free_frame_index_of_tag(frame->tag);
+
   E_SUCCESS;
 }
 
@@ -668,6 +664,9 @@ void id3v2_set_descriptor_to_frame(id3v2_frame *frame, char descriptor)
     return;
   }
 
+  if(!_own_frame_data(frame))
+    return;
+
   E_SUCCESS;
 
   switch(id3v2_get_frame_type(frame))
@@ -696,11 +695,67 @@ void _free_frame(id3v2_frame *frame)
   if(frame == NULL)
     return;
 
-  free(frame->data);
+  _release_frame_data(frame);
 
   free(frame);
 }
 
+// frees the data of a frame unless it belongs to an intern pool or image cache
+void _release_frame_data(id3v2_frame *frame)
+{
+  if(!frame->interned)
+    free(frame->data);
+
+  _release_cached_image(frame->image);
+  id3v2_free_contents_of_frame(frame);
+  if(frame->tag != NULL)
+    _free_frame_index_of_tag(frame->tag);
+
+  frame->data = NULL;
+  frame->interned = 0;
+  frame->image = NULL;
+}
+
+// makes sure the frame holds a private and complete copy of its data before it gets modified
+int _own_frame_data(id3v2_frame *frame)
+{
+  char *data;
+  char *picture = NULL;
+  int picture_size = 0;
+
+  if(!frame->interned && frame->image == NULL)
+    return 1;
+
+  if(frame->image != NULL)
+    _get_picture_from_cached_image(frame->image, &picture, &picture_size);
+
+  data = (char*)_allocate((frame->size + picture_size) * sizeof(char));
+
+  if(data == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return 0;
+  }
+
+  memcpy(data, frame->data, frame->size);
+  if(picture_size > 0)
+    memcpy(data + frame->size, picture, picture_size);
+
+  if(!frame->interned)
+    free(frame->data);
+  _release_cached_image(frame->image);
+  id3v2_free_contents_of_frame(frame);
+  if(frame->tag != NULL)
+    _free_frame_index_of_tag(frame->tag);
+
+  frame->data = data;
+  frame->size += picture_size;
+  frame->interned = 0;
+  frame->image = NULL;
+
+  return 1;
+}
+
 void id3v2_set_picture_to_frame(id3v2_frame *frame, char *picture, int size)
 {
   char *data;
@@ -724,7 +779,7 @@ void id3v2_set_picture_to_frame(id3v2_frame *frame, char *picture, int size)
     return;
   }
 
-  if(memcmp(_get_mime_type_from_buffer(picture, size), 0, 1)==0)
+  if(_get_mime_type_from_buffer(picture, size)[0] == '\0')
   {
     E_FAIL(ID3V2_ERROR_UNKNOWN_MIME_TYPE);
     return;
@@ -745,7 +800,7 @@ void id3v2_set_picture_to_frame(id3v2_frame *frame, char *picture, int size)
   if(E_GET != ID3V2_OK)
     return;
 
-  data=(char*)malloc(n_size*sizeof(char));
+  data=(char*)_allocate(n_size*sizeof(char));
 
   if(data==NULL)
   {
@@ -763,8 +818,7 @@ void id3v2_set_picture_to_frame(id3v2_frame *frame, char *picture, int size)
 
   memcpy(data+(n_size - size), picture, size);
 
-  if(frame->data != NULL)
-    free(frame->data);
+  _release_frame_data(frame);
 
   frame->data = data;
 
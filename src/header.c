@@ -13,6 +13,8 @@
 
 #include "id3v2lib.h"
 
+#define HEADER_SCAN_CHUNK 4096
+
 int _has_header_id3v2tag(id3v2_header* tag_header)
 {
 
@@ -32,9 +34,9 @@ int _has_buffer_id3v2tag(char* raw_header)
     return 0;
 }
 
-id3v2_header* _get_header_from_file(FILE *file, int offset)
+id3v2_header* _get_header_from_file(FILE *file, int64_t offset)
 {
-    char buffer[ID3V2_HEADER];
+    id3v2_io io;
 
     if(file == NULL)
     {
@@ -42,13 +44,12 @@ id3v2_header* _get_header_from_file(FILE *file, int offset)
         return NULL;
     }
 
-    fseek(file, offset, SEEK_SET);
+    id3v2_initialize_io_from_file(&io, file);
 
-    fread(buffer, ID3V2_HEADER, 1, file);
-    return _get_header_from_buffer(buffer, ID3V2_HEADER);
+    return _get_header_from_io(&io, offset);
 }
 
-id3v2_header* _get_header_from_buffer(char *buffer, int length)
+id3v2_header* _get_header_from_buffer(char *buffer, size_t length)
 {
     int position = 0;
     id3v2_header *tag_header;
@@ -69,10 +70,17 @@ id3v2_header* _get_header_from_buffer(char *buffer, int length)
 
     // checking if the as unused declared flags are set in any way
     // this would mean we stop parsing here, since we might encounter things we don't know how to handle
-    if(tag_header->flags&(1<<3)==(1<<3) ||
-       tag_header->flags&(1<<2)==(1<<2) ||
-       tag_header->flags&(1<<1)==(1<<1) ||
-       tag_header->flags&1==1)
+    if((tag_header->flags&(1<<3))==(1<<3) ||
+       (tag_header->flags&(1<<2))==(1<<2) ||
+       (tag_header->flags&(1<<1))==(1<<1) ||
+       (tag_header->flags&1)==1)
+    {
+      free(tag_header);
+      return NULL;
+    }
+
+    // in 2.2 the same flag marks a compressed tag, for which the standard doesn't define any compression yet
+    if(tag_header->major_version == 2 && (tag_header->flags&(1<<6))==(1<<6))
     {
       free(tag_header);
       return NULL;
@@ -80,17 +88,26 @@ id3v2_header* _get_header_from_buffer(char *buffer, int length)
 
     tag_header->tag_size = syncint_decode(btoi(buffer, ID3V2_HEADER_SIZE, position += ID3V2_HEADER_FLAGS));
 
-    if(tag_header->flags&(1<<6)==(1<<6))
-      // an extended header exists, so we retrieve the actual size of it and save it into the struct
-      tag_header->extended_header_size = syncint_decode(btoi(buffer, ID3V2_EXTENDED_HEADER_SIZE, position += ID3V2_HEADER_SIZE));
+    if((tag_header->flags&(1<<6))==(1<<6))
+    {
+      // an extended header exists, so we retrieve the actual size of it, its size bytes included, and save it into the struct
+      // 2.4 counts the size bytes in its synchsafe size already, 2.3 neither counts them nor uses a synchsafe size
+      position += ID3V2_HEADER_SIZE;
+      if(tag_header->major_version == 4)
+        tag_header->extended_header_size = syncint_decode(btoi(buffer, ID3V2_EXTENDED_HEADER_SIZE, position));
+      else
+        tag_header->extended_header_size = btoi(buffer, ID3V2_EXTENDED_HEADER_SIZE, position) + ID3V2_EXTENDED_HEADER_SIZE;
+    }
     else
       // no extended header existing
       tag_header->extended_header_size = 0;
 
-    if(tag_header->flags&(1<<4)==(1<<4))
+    if((tag_header->flags&(1<<4))==(1<<4))
       // footer detected, adding the size
       tag_header->tag_size += 10;
 
+    STATS_ADD(headers_parsed, 1);
+
     return tag_header;
 }
 
@@ -122,78 +139,6 @@ int id3v2_get_tag_version(id3v2_tag *tag)
   }
 }
 
-void _find_header_offsets_in_file(FILE *file, int **location, int *size)
-{
-  char byte; // currently processing byte
-  id3v2_header *header;
-  char *header_bytes; // used to store the header bytes found
-  int *offsets;
-  char scanning = 1; // still scanning?
-
-  *size = 0;
-
-  header_bytes=(char *)malloc(10*sizeof(char));
-
-  if(header_bytes==NULL)
-  {
-    return;
-  }
-
-  offsets=(int*)malloc(sizeof(int));
-
-  if(offsets==NULL)
-  {
-    free(header_bytes);
-    return;
-  }
-
-  fseek(file, 0, SEEK_SET);
-
-  while( (byte = fgetc(file)) != EOF && scanning)
-  {
-    if(_identify_id3v2tag(byte))
-    {
-      // we successfully found an id3 tag
-      fseek(file, -10, SEEK_CUR);
-      // so we get the header bytes and parse them to find out if we actually found a parseable header
-      fgets(header_bytes, 10, file);
-      header=_get_header_from_buffer(header_bytes, 10);
-      if(header==NULL)
-        continue;
-      // we successfully found something useful
-      offsets[*size] = ftell(file)-9;
-      (*size)++;
-      offsets=realloc(offsets, ((*size)+1)*sizeof(int));
-      if(offsets==NULL)
-      {
-        free(header_bytes);
-        *size = 0;
-        return;
-      }
-      if(fseek(file, header->tag_size+1, SEEK_CUR)!=0)
-        // seems like the tag isn't fully contained in this file, otherwise this shouldn't happen
-        scanning = 0;
-    }
-  }
-
-  _identify_id3v2tag(0xFF); // reset it, just for sure
-
-  free(header_bytes);
-
-  if( *size > 0)
-  {
-    offsets=(int *)realloc(offsets, (*size)*sizeof(int));
-    if(offsets==NULL)
-    {
-      *size = 0;
-      return;
-    }
-    *location = offsets;
-  }
-
-  return;
-}
-
 int _identify_id3v2tag(char byte)
 {
   static char pattern_position = 0; // position in pattern
@@ -243,57 +188,283 @@ int _identify_id3v2tag(char byte)
   return (pattern_position == 10);
 }
 
-void _find_header_offsets_in_buffer(char *buffer, int length, int **location, int *size)
+id3v2_header* _get_header_from_io(id3v2_io *io, int64_t offset)
 {
+  char buffer[ID3V2_HEADER + ID3V2_EXTENDED_HEADER_SIZE] = {0}; // the extended header size gets parsed too
+
+  if(_read_from_io(io, offset, buffer, sizeof(buffer)) < ID3V2_HEADER)
+    return NULL;
+
+  return _get_header_from_buffer(buffer, ID3V2_HEADER);
+}
+
+// checks the parts of a header which are fixed, before it gets parsed
+static int _is_header_candidate(char *bytes)
+{
+  return memcmp(bytes, "ID3", 3) == 0 &&
+         (unsigned char)bytes[3] != 0xFF && (unsigned char)bytes[4] != 0xFF &&
+         ((bytes[6] | bytes[7] | bytes[8] | bytes[9]) & 0x80) == 0;
+}
+
+// looks at every byte between start and end for a header, skipping the tags found
+// the scan only keeps local state, so several of them may run at the same time
+void _scan_header_offsets_in_io(id3v2_io *io, int64_t start, int64_t end, int64_t **location, int *size)
+{
+  char chunk[HEADER_SCAN_CHUNK];
+  int chunk_size;
   id3v2_header *header;
-  int *offsets;
-  int position = 0;
-  char scanning = 1; // still scanning?
+  int i;
+  int64_t *offsets = NULL;
+  int64_t position = start;
+  int64_t timer;
 
   *size = 0;
 
-  offsets=(int*)malloc(sizeof(int));
+  STATS_START_TIMER(timer);
 
-  if(offsets==NULL)
-    return;
+  _hint_io(io, start, end - start);
 
-  while( position < length && scanning)
+  while(end - position >= ID3V2_HEADER)
   {
-    if(_identify_id3v2tag(buffer[position]))
+    chunk_size = end - position < HEADER_SCAN_CHUNK ? (int)(end - position) : HEADER_SCAN_CHUNK;
+    chunk_size = _read_from_io(io, position, chunk, chunk_size);
+
+    if(chunk_size < ID3V2_HEADER)
+      break;
+
+    STATS_ADD(bytes_scanned, chunk_size);
+
+    for(i = 0; i + ID3V2_HEADER <= chunk_size; i++)
     {
-      // we successfully found an id3 tag
-      // so we get the header bytes and parse them to find out if we actually found a parseable header
-      header=_get_header_from_buffer(buffer+position-10, 10);
-      if(header==NULL)
+      if(!_is_header_candidate(chunk + i))
         continue;
-      // we successfully found something useful
-      offsets[*size] = position-10;
-      (*size)++;
-      offsets=realloc(offsets, ((*size)+1)*sizeof(int));
-      if(offsets==NULL)
-      {
-        *size = 0;
-        return;
-      }
-      if(position+header->tag_size>=length)
-        // seems like the tag isn't fully contained in this file, otherwise this shouldn't happen
-        scanning = 0;
+
+      header = _get_header_from_io(io, position + i);
+      if(header == NULL)
+        continue;
+
+      // continue behind the tag, or stop if there is no memory left to remember it
+      if(_add_header_offset(&offsets, size, position + i))
+        position += i + ID3V2_HEADER + header->tag_size;
+      else
+        position = end;
+      free(header);
+      break;
     }
-    position++;
+
+    // headers crossing the end of the chunk get found by the next one
+    if(i + ID3V2_HEADER > chunk_size)
+      position += chunk_size - ID3V2_HEADER + 1;
+  }
+
+  if(*size > 0)
+    *location = offsets;
+  else
+    free(offsets);
+
+  STATS_STOP_TIMER(scan_nanoseconds, timer);
+}
+
+void _scan_header_offsets_in_file(FILE *file, int64_t **location, int *size)
+{
+  id3v2_io io;
+  int64_t length;
+
+  id3v2_initialize_io_from_file(&io, file);
+  length = _get_size_of_io(&io);
+
+  *size = 0;
+
+  if(length < 0)
+    return;
+
+  _scan_header_offsets_in_io(&io, 0, length, location, size);
+}
+
+void _scan_header_offsets_in_buffer(char *buffer, size_t length, int64_t **location, int *size)
+{
+  id3v2_io io;
+  io_buffer source;
+
+  source.buffer = buffer;
+  source.length = length;
+  _initialize_io_from_buffer(&io, &source);
+
+  _scan_header_offsets_in_io(&io, 0, (int64_t)length, location, size);
+}
+
+// returns the tag size stored in a v2.4 footer or -1 if there is no footer
+int _get_tag_size_from_footer(char *footer)
+{
+  if(memcmp(footer, "3DI", 3) != 0 || footer[3] != ID3V2_4)
+    return -1;
+
+  if((footer[6] | footer[7] | footer[8] | footer[9]) & 0x80)
+    return -1;
+
+  return syncint_decode(btoi(footer, ID3V2_HEADER_SIZE, 6));
+}
+
+// inserts an offset into the ascending offset list, unless it is already known
+int _add_header_offset(int64_t **offsets, int *size, int64_t offset)
+{
+  int64_t *new_offsets;
+  int i;
+
+  for(i = 0; i < *size; i++)
+  {
+    if((*offsets)[i] == offset)
+      return 1;
+  }
+
+  new_offsets = (int64_t*)_reallocate(*offsets, ((*size)+1)*sizeof(int64_t));
+
+  if(new_offsets == NULL)
+    return 0;
+
+  for(i = *size; i > 0 && new_offsets[i-1] > offset; i--)
+    new_offsets[i] = new_offsets[i-1];
+
+  new_offsets[i] = offset;
+  *offsets = new_offsets;
+  (*size)++;
+
+  TRACE(header, ID3V2_TRACE_HEADER, offset, -1, -1, NULL, -1, -1);
+
+  return 1;
+}
+
+// finds tags by following their sizes from the start and their footers from the end
+// instead of looking at every single byte in between
+void _locate_header_offsets(id3v2_io *io, int64_t length, int64_t **location, int *size)
+{
+  // a header is parsed with the extended header size behind it, which has to be zeroes when not read
+  char bytes[ID3V1_TAG + ID3V1_ENHANCED_TAG + ID3V2_FOOTER] = {0};
+  int64_t end;
+  char *footer;
+  id3v2_header *header;
+  int64_t offset = 0;
+  int64_t *offsets = NULL;
+  int64_t start;
+  int tag_size;
+  int64_t tail_offset;
+  int tail_size;
+  int64_t timer;
+
+  *size = 0;
+
+  STATS_START_TIMER(timer);
+
+  // the usual place, maybe with further tags following right behind
+  while(offset + ID3V2_HEADER <= length && _read_from_io(io, offset, bytes, ID3V2_HEADER) == ID3V2_HEADER)
+  {
+    STATS_ADD(bytes_scanned, ID3V2_HEADER);
+    header = _get_header_from_buffer(bytes, ID3V2_HEADER);
+    if(header == NULL)
+      break;
+    tag_size = header->tag_size;
+    free(header);
+    if(!_add_header_offset(&offsets, size, offset))
+      break;
+    offset += ID3V2_HEADER + tag_size;
   }
 
-  _identify_id3v2tag(0xFF); // reset it, just for sure
+  // appended tags end with a footer, which may be followed by an ID3v1 (and Enhanced TAG+) trailer
+  tail_size = length - offset < (int64_t)sizeof(bytes) ? (int)(length - offset) : (int)sizeof(bytes);
+  tail_offset = length - tail_size;
+  end = length;
+
+  _hint_io(io, tail_offset, tail_size);
 
-  if( *size > 0)
+  if(tail_size > 0 && _read_from_io(io, tail_offset, bytes, tail_size) == tail_size)
   {
-    offsets=(int *)realloc(offsets, (*size)*sizeof(int));
-    if(offsets==NULL)
+    STATS_ADD(bytes_scanned, tail_size);
+
+    if(tail_size >= ID3V1_TAG && memcmp(bytes + tail_size - ID3V1_TAG, "TAG", 3) == 0)
     {
-      *size = 0;
-      return;
+      end -= ID3V1_TAG;
+      if(tail_size >= ID3V1_TAG + ID3V1_ENHANCED_TAG &&
+         memcmp(bytes + tail_size - ID3V1_TAG - ID3V1_ENHANCED_TAG, "TAG+", 4) == 0)
+        end -= ID3V1_ENHANCED_TAG;
+    }
+
+    while(end - offset >= ID3V2_HEADER + ID3V2_FOOTER)
+    {
+      if(end - ID3V2_FOOTER >= tail_offset)
+        footer = bytes + (end - ID3V2_FOOTER - tail_offset);
+      else if(_read_from_io(io, end - ID3V2_FOOTER, bytes, ID3V2_FOOTER) == ID3V2_FOOTER)
+      {
+        STATS_ADD(bytes_scanned, ID3V2_FOOTER);
+        footer = bytes;
+        tail_offset = end - ID3V2_FOOTER; // the tail buffer got replaced
+        tail_size = ID3V2_FOOTER;
+      }
+      else
+        break;
+
+      tag_size = _get_tag_size_from_footer(footer);
+      if(tag_size < 0)
+        break;
+
+      start = end - ID3V2_FOOTER - tag_size - ID3V2_HEADER;
+      if(start < offset)
+        break;
+
+      if(start >= tail_offset && start + ID3V2_HEADER + ID3V2_EXTENDED_HEADER_SIZE <= tail_offset + tail_size)
+        header = _get_header_from_buffer(bytes + (start - tail_offset), ID3V2_HEADER);
+      else if(_read_from_io(io, start, bytes, ID3V2_HEADER) == ID3V2_HEADER)
+      {
+        STATS_ADD(bytes_scanned, ID3V2_HEADER);
+        memset(bytes + ID3V2_HEADER, 0, ID3V2_EXTENDED_HEADER_SIZE);
+        tail_offset = start;
+        tail_size = ID3V2_HEADER;
+        header = _get_header_from_buffer(bytes, ID3V2_HEADER);
+      }
+      else
+        break;
+
+      if(header == NULL)
+        break;
+      free(header);
+
+      if(!_add_header_offset(&offsets, size, start))
+        break;
+      end = start;
     }
-    *location = offsets;
   }
 
-  return;
-}
\ No newline at end of file
+  if(*size > 0)
+    *location = offsets;
+  else
+    free(offsets);
+
+  STATS_STOP_TIMER(scan_nanoseconds, timer);
+}
+
+void _find_header_offsets_in_file(FILE *file, int64_t **location, int *size)
+{
+  id3v2_io io;
+  int64_t length;
+
+  id3v2_initialize_io_from_file(&io, file);
+  length = _get_size_of_io(&io);
+
+  *size = 0;
+
+  if(length < 0)
+    return;
+
+  _locate_header_offsets(&io, length, location, size);
+}
+
+void _find_header_offsets_in_buffer(char *buffer, size_t length, int64_t **location, int *size)
+{
+  id3v2_io io;
+  io_buffer source;
+
+  source.buffer = buffer;
+  source.length = length;
+  _initialize_io_from_buffer(&io, &source);
+
+  _locate_header_offsets(&io, (int64_t)length, location, size);
+}
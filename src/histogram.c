@@ -0,0 +1,124 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+#define READ_HISTOGRAM_BUCKETS 20 // bucket i counts tags of up to 1 KB << i bytes, the last one everything bigger
+#define READ_HISTOGRAM_SAMPLES 8 // tags seen before the histogram replaces the default
+#define READ_HISTOGRAM_PERCENTILE 90 // share of the tags which should fit into the first read
+
+struct id3v2_read_histogram
+{
+  int buckets[READ_HISTOGRAM_BUCKETS];
+  int count;
+  int first_read_size;
+  void *mutex;
+};
+
+id3v2_read_histogram *id3v2_new_read_histogram()
+{
+  id3v2_read_histogram *histogram = (id3v2_read_histogram*)_allocate(sizeof(id3v2_read_histogram));
+
+  if(histogram == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  histogram->mutex = _new_mutex();
+
+  if(histogram->mutex == NULL)
+  {
+    free(histogram);
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  memset(histogram->buckets, 0, sizeof(histogram->buckets));
+  histogram->count = 0;
+  histogram->first_read_size = ID3V2_FIRST_READ;
+
+  E_SUCCESS;
+
+  return histogram;
+}
+
+void id3v2_free_read_histogram(id3v2_read_histogram *histogram)
+{
+  if(histogram == NULL)
+    return;
+
+  _free_mutex(histogram->mutex);
+  free(histogram);
+
+  E_SUCCESS;
+}
+
+// size includes the header, so a whole tag fits into a first read of that size
+void _add_tag_size_to_read_histogram(id3v2_read_histogram *histogram, int size)
+{
+  int bucket = 0;
+  int covered = 0;
+  int i;
+
+  if(histogram == NULL || size < 0)
+    return;
+
+  while(bucket < READ_HISTOGRAM_BUCKETS - 1 && size > (1024 << bucket))
+    bucket++;
+
+  _lock_mutex(histogram->mutex);
+
+  // halve everything once in a while, so the histogram follows a changing collection
+  if(histogram->count == INT32_MAX / 2)
+  {
+    histogram->count = 0;
+    for(i = 0; i < READ_HISTOGRAM_BUCKETS; i++)
+    {
+      histogram->buckets[i] /= 2;
+      histogram->count += histogram->buckets[i];
+    }
+  }
+
+  histogram->buckets[bucket]++;
+  histogram->count++;
+
+  if(histogram->count >= READ_HISTOGRAM_SAMPLES)
+  {
+    for(i = 0; i < READ_HISTOGRAM_BUCKETS - 1; i++)
+    {
+      covered += histogram->buckets[i];
+      if((int64_t)covered * 100 >= (int64_t)histogram->count * READ_HISTOGRAM_PERCENTILE)
+        break;
+    }
+
+    histogram->first_read_size = (1024 << i) < ID3V2_FIRST_READ_LIMIT ? (1024 << i) : ID3V2_FIRST_READ_LIMIT;
+  }
+
+  _unlock_mutex(histogram->mutex);
+}
+
+// returns the amount of bytes to read at once where a tag is expected
+int id3v2_get_first_read_size_from_read_histogram(id3v2_read_histogram *histogram)
+{
+  int size;
+
+  if(histogram == NULL)
+    return ID3V2_FIRST_READ;
+
+  _lock_mutex(histogram->mutex);
+  size = histogram->first_read_size;
+  _unlock_mutex(histogram->mutex);
+
+  return size;
+}
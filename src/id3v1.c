@@ -0,0 +1,191 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+// ID3v1 trailer layout
+#define ID3V1_TITLE 3
+#define ID3V1_ARTIST 33
+#define ID3V1_ALBUM 63
+#define ID3V1_YEAR 93
+#define ID3V1_COMMENT 97
+#define ID3V1_TRACK 126
+#define ID3V1_GENRE 127
+#define ID3V1_FIELD 30
+#define ID3V1_YEAR_FIELD 4
+
+// Enhanced TAG+ layout, each text field continues the one of the ID3v1 trailer
+#define ID3V1_ENHANCED_TITLE 4
+#define ID3V1_ENHANCED_ARTIST 64
+#define ID3V1_ENHANCED_ALBUM 124
+#define ID3V1_ENHANCED_GENRE 185
+#define ID3V1_ENHANCED_FIELD 60
+#define ID3V1_ENHANCED_GENRE_FIELD 30
+
+#define ID3V1_NO_GENRE 0xFF
+
+// returns the length of a fixed size field without its padding
+static int _get_length_of_v1_field(char *field, int size)
+{
+  int i;
+
+  // the field ends at the first zero byte, spaces at the end are padding too
+  for(i = 0; i < size && field[i] != '\0'; i++);
+
+  while(i > 0 && field[i-1] == ' ')
+    i--;
+
+  return i;
+}
+
+static void _add_v1_text_frame_to_tag(id3v2_tag *tag, char *id, char *text, int size, char is_comment)
+{
+  id3v2_frame *frame;
+
+  if(size == 0)
+    return;
+
+  frame = id3v2_new_frame(tag, is_comment ? ID3V2_COMMENT_FRAME : ID3V2_TEXT_FRAME);
+
+  if(frame == NULL)
+    return;
+
+  id3v2_set_id_to_frame(frame, id);
+  id3v2_set_text_to_frame(frame, text, size, ID3V2_ISO_ENCODING);
+}
+
+// joins an ID3v1 field with its TAG+ continuation
+static void _add_v1_long_text_frame_to_tag(id3v2_tag *tag, char *id, char *field, char *enhanced_field)
+{
+  char text[ID3V1_FIELD + ID3V1_ENHANCED_FIELD];
+  int size;
+
+  if(enhanced_field != NULL && _get_length_of_v1_field(enhanced_field, ID3V1_ENHANCED_FIELD) > 0)
+  {
+    memcpy(text, field, ID3V1_FIELD);
+    memcpy(text + ID3V1_FIELD, enhanced_field, ID3V1_ENHANCED_FIELD);
+    size = ID3V1_FIELD + _get_length_of_v1_field(enhanced_field, ID3V1_ENHANCED_FIELD);
+  }
+  else
+  {
+    size = _get_length_of_v1_field(field, ID3V1_FIELD);
+    memcpy(text, field, size);
+  }
+
+  _add_v1_text_frame_to_tag(tag, id, text, size, 0);
+}
+
+// maps an ID3v1 trailer (and an Enhanced TAG+ block in front of it) at the end of the buffer onto a v2.3 tag
+id3v2_tag *id3v2_load_v1_tag_from_buffer(char *buffer, size_t length)
+{
+  char *enhanced = NULL;
+  char number[8];
+  id3v2_tag *tag;
+  char *trailer;
+  int comment_size = ID3V1_FIELD;
+
+  if(buffer == NULL || length < ID3V1_TAG || memcmp(buffer + length - ID3V1_TAG, "TAG", 3) != 0)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  trailer = buffer + length - ID3V1_TAG;
+
+  if(length >= ID3V1_TAG + ID3V1_ENHANCED_TAG && memcmp(trailer - ID3V1_ENHANCED_TAG, "TAG+", 4) == 0)
+    enhanced = trailer - ID3V1_ENHANCED_TAG;
+
+  tag = id3v2_new_tag();
+
+  if(tag == NULL)
+    return NULL;
+
+  memcpy(tag->header->tag, "ID3", ID3V2_HEADER_TAG);
+  tag->header->major_version = ID3V2_3;
+  tag->header->tag_size = 0;
+  tag->header->extended_header_size = 0;
+
+  _add_v1_long_text_frame_to_tag(tag, "TIT2", trailer + ID3V1_TITLE, enhanced ? enhanced + ID3V1_ENHANCED_TITLE : NULL);
+  _add_v1_long_text_frame_to_tag(tag, "TPE1", trailer + ID3V1_ARTIST, enhanced ? enhanced + ID3V1_ENHANCED_ARTIST : NULL);
+  _add_v1_long_text_frame_to_tag(tag, "TALB", trailer + ID3V1_ALBUM, enhanced ? enhanced + ID3V1_ENHANCED_ALBUM : NULL);
+  _add_v1_text_frame_to_tag(tag, "TYER", trailer + ID3V1_YEAR, _get_length_of_v1_field(trailer + ID3V1_YEAR, ID3V1_YEAR_FIELD), 0);
+
+  // ID3v1.1 steals the last two comment bytes for the track number
+  if(trailer[ID3V1_TRACK - 1] == '\0' && trailer[ID3V1_TRACK] != '\0')
+  {
+    comment_size -= 2;
+    sprintf(number, "%d", (unsigned char)trailer[ID3V1_TRACK]);
+    _add_v1_text_frame_to_tag(tag, "TRCK", number, (int)strlen(number), 0);
+  }
+
+  _add_v1_text_frame_to_tag(tag, "COMM", trailer + ID3V1_COMMENT, _get_length_of_v1_field(trailer + ID3V1_COMMENT, comment_size), 1);
+
+  // the free text genre of TAG+ is more precise than the genre index
+  if(enhanced != NULL && _get_length_of_v1_field(enhanced + ID3V1_ENHANCED_GENRE, ID3V1_ENHANCED_GENRE_FIELD) > 0)
+    _add_v1_text_frame_to_tag(tag, "TCON", enhanced + ID3V1_ENHANCED_GENRE, _get_length_of_v1_field(enhanced + ID3V1_ENHANCED_GENRE, ID3V1_ENHANCED_GENRE_FIELD), 0);
+  else if((unsigned char)trailer[ID3V1_GENRE] != ID3V1_NO_GENRE)
+  {
+    // v2.3 refers to ID3v1 genres by their index
+    sprintf(number, "(%d)", (unsigned char)trailer[ID3V1_GENRE]);
+    _add_v1_text_frame_to_tag(tag, "TCON", number, (int)strlen(number), 0);
+  }
+
+  E_SUCCESS;
+
+  return tag;
+}
+
+id3v2_tag *id3v2_load_v1_tag_from_file(FILE *file)
+{
+  char buffer[ID3V1_TAG + ID3V1_ENHANCED_TAG];
+  int64_t length;
+  int size;
+
+  if(file == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    return NULL;
+  }
+
+  length = _get_length_of_file(file);
+
+  if(length < 0)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    return NULL;
+  }
+
+  size = length < (int64_t)sizeof(buffer) ? (int)length : (int)sizeof(buffer);
+
+  // both trailers are fetched with a single read
+  _seek_in_file(file, length - size, SEEK_SET);
+
+  if(fread(buffer, 1, size, file) != (size_t)size)
+  {
+    E_FAIL(ID3V2_ERROR_INSUFFICIENT_DATA);
+    return NULL;
+  }
+
+  return id3v2_load_v1_tag_from_buffer(buffer, size);
+}
+
+// returns the first ID3v2 tag of the file or, if there is none, the ID3v1 trailer mapped onto a tag
+id3v2_tag *id3v2_load_best_tag_from_file(FILE *file)
+{
+  id3v2_tag *tag = id3v2_load_tag_from_file(file);
+
+  if(tag != NULL)
+    return tag;
+
+  return id3v2_load_v1_tag_from_file(file);
+}
@@ -20,13 +20,13 @@ int _add_allocation_to_tag(id3v2_tag *tag, void *allocation)
 
   if(tag->allocation_count == 0)
   {
-    tag->allocations = (void**)malloc(sizeof(void*));
+    tag->allocations = (void**)_allocate(sizeof(void*));
     if(tag->allocations == NULL)
       return 0;
   }
   else
   {
-    tag->allocations = (void**)realloc(tag->allocations, (tag->allocation_count+1)*sizeof(void*));
+    tag->allocations = (void**)_reallocate(tag->allocations, (tag->allocation_count+1)*sizeof(void*));
     if(tag->allocations == NULL)
     {
       tag->allocation_count = 0;
@@ -41,86 +41,271 @@ int _add_allocation_to_tag(id3v2_tag *tag, void *allocation)
   return 1;
 }
 
-id3v2_tag* id3v2_load_tag_from_file(FILE *file)
+// reads the tag at offset, speculating that it fits into the first read, so that most tags cost a single read
+// returns NULL and leaves found at 0 if there is no header at offset
+static id3v2_tag *_load_tag_at_offset_from_io(id3v2_io *io, int64_t offset, id3v2_load_options *options, char *found)
 {
-    char *buffer;
-    int count;
-    id3v2_header *header;
-    int *offsets;
-    id3v2_tag *tag;
-    int tag_size;
+  char *buffer;
+  int first_size;
+  id3v2_header *header;
+  char *larger_buffer;
+  int read_size;
+  id3v2_tag *tag;
+  int tag_size;
 
-    if(file==NULL)
+  *found = 0;
+
+  first_size = id3v2_get_first_read_size_from_read_histogram(options != NULL ? options->read_histogram : NULL);
+
+  buffer = (char*)_allocate(first_size * sizeof(char));
+
+  if(buffer == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  memset(buffer, 0, ID3V2_HEADER + ID3V2_EXTENDED_HEADER_SIZE); // the extended header size gets parsed too
+
+  _hint_io(io, offset, first_size);
+  read_size = _read_from_io(io, offset, buffer, first_size);
+
+  header = _get_header_from_buffer(buffer, read_size);
+
+  if(header == NULL)
+  {
+    free(buffer);
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  *found = 1;
+  tag_size = ID3V2_HEADER + header->tag_size;
+  free(header);
+
+  if(options != NULL)
+    _add_tag_size_to_read_histogram(options->read_histogram, tag_size);
+
+  // the speculation didn't work out, so fetch the rest of the tag
+  if(read_size == first_size && tag_size > read_size)
+  {
+    larger_buffer = (char*)_reallocate(buffer, tag_size * sizeof(char));
+
+    if(larger_buffer == NULL)
     {
-      E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+      free(buffer);
+      E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
       return NULL;
     }
 
-    // parse file for id3 tags
-    _find_header_offsets_in_file(file, &offsets, &count);
+    buffer = larger_buffer;
+    _hint_io(io, offset + read_size, tag_size - read_size);
+    read_size += _read_from_io(io, offset + read_size, buffer + read_size, tag_size - read_size);
+  }
+
+  tag = id3v2_load_tag_from_buffer_with_options(buffer, read_size, options);
+  free(buffer);
+
+  return tag;
+}
+
+static void _find_header_offsets_in_io(id3v2_io *io, int64_t length,
+                                       int64_t **offsets, int *count, id3v2_load_options *options)
+{
+  if(options != NULL && options->deep_scan)
+    _scan_header_offsets_in_io(io, 0, length, offsets, count);
+  else
+    _locate_header_offsets(io, length, offsets, count);
+}
+
+id3v2_tag* id3v2_load_tag_from_io(id3v2_io *io)
+{
+  return id3v2_load_tag_from_io_with_options(io, NULL);
+}
+
+// reads as little as possible: usually one read where the tag is expected,
+// the end of the source is only looked at if the tag isn't there
+static id3v2_tag* _load_tag_from_io(id3v2_io *io, id3v2_load_options *options)
+{
+  int count;
+  char found;
+  int64_t length;
+  int64_t *offsets;
+  int64_t offset;
+  id3v2_tag *tag;
+
+  if(io == NULL || io->read_at == NULL || io->size == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    return NULL;
+  }
+
+  // a caller who knows where the tag is saves us from looking for it, usually it's right at the start
+  offset = options != NULL && options->offset_hint >= 0 ? options->offset_hint : 0;
+  tag = _load_tag_at_offset_from_io(io, offset, options, &found);
+
+  if(found)
+    return tag;
+
+  length = _get_size_of_io(io);
+
+  if(length < 0)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    return NULL;
+  }
+
+  // parse file for id3 tags
+  _find_header_offsets_in_io(io, length, &offsets, &count, options);
+
+  // no headers found?
+  if(count==0)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  // todo: process multiple tags in files consequently, meaning
+    // tag appending
+    // tag updating
+    // tag replacing
+  // for now, we will just take the first tag found in the file
+
+  offset = offsets[0];
+  free(offsets);
+
+  return _load_tag_at_offset_from_io(io, offset, options, &found);
+}
+
+id3v2_tag* id3v2_load_tag_from_io_with_options(id3v2_io *io, id3v2_load_options *options)
+{
+  int64_t start = 0;
+  id3v2_tag *tag;
+
+  if(TRACE_ENABLED(load_end))
+    start = _get_monotonic_nanoseconds();
+
+  TRACE(load_start, ID3V2_TRACE_LOAD_START, -1, -1, -1, NULL, -1, -1);
+
+  tag = _load_tag_from_io(io, options);
+
+  TRACE(load_end, ID3V2_TRACE_LOAD_END, -1, tag != NULL ? tag->header->tag_size + ID3V2_HEADER : -1,
+        E_GET, NULL, -1, start != 0 ? _get_monotonic_nanoseconds() - start : -1);
+
+  return tag;
+}
+
+id3v2_tag* id3v2_load_tag_from_file(FILE *file)
+{
+    return id3v2_load_tag_from_file_with_options(file, NULL);
+}
+
+id3v2_tag* id3v2_load_tag_from_file_with_options(FILE *file, id3v2_load_options *options)
+{
+    id3v2_io io;
 
-    // no headers found?
-    if(count==0)
+    if(file==NULL)
     {
-      E_FAIL(ID3V2_ERROR_NOT_FOUND);
+      E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
       return NULL;
     }
 
-    // todo: process multiple tags in files consequently, meaning
-      // tag appending
-      // tag updating
-      // tag replacing
-    // for now, we will just take the first tag found in the file
+    id3v2_initialize_io_from_file(&io, file);
+
+    return id3v2_load_tag_from_io_with_options(&io, options);
+}
+
+id3v2_tag* id3v2_load_tag_from_fd(int fd)
+{
+    return id3v2_load_tag_from_fd_with_options(fd, NULL);
+}
 
-    header = _get_header_from_file(file, offsets[0]);
+// like id3v2_load_tag_from_file_with_options, but every access is a positional read
+// so the descriptor may be shared by several threads
+id3v2_tag* id3v2_load_tag_from_fd_with_options(int fd, id3v2_load_options *options)
+{
+    id3v2_io io;
 
-    if(header==NULL)
+    if(fd < 0)
     {
-      // whatever went wrong here, since we already found a header there
-      E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+      E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
       return NULL;
     }
 
-    // get header size
-    tag_size = header->tag_size;
-    free(header);
+    id3v2_initialize_io_from_fd(&io, fd);
 
-    // allocate buffer and fetch header
-    buffer = (char*) malloc((10+tag_size) * sizeof(char));
-    if(buffer == NULL)
-    {
-        E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
-        return NULL;
-    }
+    return id3v2_load_tag_from_io_with_options(&io, options);
+}
+
+// the SEEK frame of a v2.4 tag points to the next tag, counted from the end of the present one
+// returns the offset of the next tag or -1 if there is no such pointer
+static int64_t _get_next_tag_offset_from_tag(id3v2_tag *tag, int64_t offset)
+{
+  id3v2_frame *frame;
 
-    fseek(file, offsets[0], SEEK_SET);
+  if(id3v2_get_tag_version(tag) != ID3V2_4)
+    return -1;
 
-    fread(buffer, tag_size+10, 1, file);
-    free(offsets);
+  frame = id3v2_get_frame_from_tag(tag, "SEEK");
 
-    //parse free and return
-    tag = id3v2_load_tag_from_buffer(buffer, tag_size+10);
-    free(buffer);
+  if(frame == NULL || frame->size < 4)
+    return -1;
 
-    return tag;
+  return offset + ID3V2_HEADER + tag->header->tag_size + btoi(frame->data, 4, 0);
 }
 
-void id3v2_load_tags_from_file(FILE *file, id3v2_tag ***tags, int *count)
+// makes room for newly discovered tags
+static int _resize_tag_list(id3v2_tag ***tags, int count)
 {
-  char *buffer;
+  id3v2_tag **resized_tags = (id3v2_tag **)_reallocate(*tags, count*sizeof(id3v2_tag *));
+
+  if(resized_tags == NULL)
+    return 0;
+
+  *tags = resized_tags;
+
+  return 1;
+}
+
+static void _free_tag_list(id3v2_tag **tags, int count)
+{
+  int i;
+
+  for(i = 0; i < count; i++)
+    id3v2_free_tag(tags[i]);
+
+  free(tags);
+}
+
+void id3v2_load_tags_from_io(id3v2_io *io, id3v2_tag ***tags, int *count)
+{
+  id3v2_load_tags_from_io_with_options(io, tags, count, NULL);
+}
+
+void id3v2_load_tags_from_io_with_options(id3v2_io *io, id3v2_tag ***tags, int *count, id3v2_load_options *options)
+{
+  char found;
+  int found_count;
+  int64_t *found_offsets;
   id3v2_header *header;
   int i;
-  int *offsets;
-  int tag_size;
+  int j;
+  int64_t length;
+  int64_t next_offset;
+  int64_t *offsets;
+  char pointers = 0; // did any tag point to another one?
+  int64_t tag_end;
 
-  if(file == NULL)
+  length = io != NULL && io->read_at != NULL && io->size != NULL ? _get_size_of_io(io) : -1;
+
+  if(length < 0)
   {
     E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
     *count = 0;
     return;
   }
 
-  _find_header_offsets_in_file(file, &offsets, count);
+  _find_header_offsets_in_io(io, length, &offsets, count, options);
 
   if(*count == 0)
   {
@@ -128,71 +313,135 @@ void id3v2_load_tags_from_file(FILE *file, id3v2_tag ***tags, int *count)
     return;
   }
 
-  *tags= (id3v2_tag **)malloc((*count)*sizeof(id3v2_tag *));
+  *tags= (id3v2_tag **)_allocate((*count)*sizeof(id3v2_tag *));
 
   if(*tags == NULL)
   {
     E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    free(offsets);
     *count = 0;
     return;
   }
 
   for(i = 0; i < *count; i++)
   {
-    fseek(file, offsets[i], SEEK_SET);
+    (*tags)[i] = _load_tag_at_offset_from_io(io, offsets[i], options, &found);
 
-    header = _get_header_from_file(file, offsets[i]);
-
-    if(header == NULL)
+    if((*tags)[i] == NULL)
     {
-      E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+      _free_tag_list(*tags, i);
+      free(offsets);
       *count = 0;
       return;
     }
 
-    tag_size = header->tag_size;
+    // follow the pointer to the next tag, it may be anywhere in the file
+    next_offset = _get_next_tag_offset_from_tag((*tags)[i], offsets[i]);
 
-    free(header);
+    if(next_offset >= 0)
+    {
+      pointers = 1;
+      header = next_offset > offsets[i] ? _get_header_from_io(io, next_offset) : NULL;
+      if(header != NULL)
+      {
+        free(header);
+        _add_header_offset(&offsets, count, next_offset);
+      }
+    }
+
+    // a single tag without pointers might still be followed by another one closely behind it
+    tag_end = offsets[0] + ID3V2_HEADER + (*tags)[0]->header->tag_size;
+    if(*count == 1 && !pointers && (options == NULL || !options->deep_scan) && tag_end < length)
+    {
+      _scan_header_offsets_in_io(io, tag_end,
+                                 length - tag_end < ID3V2_BOUNDED_SCAN ? length : tag_end + ID3V2_BOUNDED_SCAN,
+                                 &found_offsets, &found_count);
 
-    fseek(file, -10, SEEK_CUR);
+      for(j = 0; j < found_count; j++)
+        _add_header_offset(&offsets, count, found_offsets[j]);
 
-    buffer = (char*)malloc((tag_size+10) * sizeof(char));
+      if(found_count > 0)
+        free(found_offsets);
+    }
 
-    if(buffer == NULL)
+    if(!_resize_tag_list(tags, *count))
     {
       E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+      _free_tag_list(*tags, i + 1);
+      free(offsets);
       *count = 0;
       return;
     }
+  }
 
-    fread(buffer, tag_size+10, 1, file);
+  free(offsets);
 
-    (*tags)[i]=id3v2_load_tag_from_buffer(buffer, tag_size+10);
+  E_SUCCESS;
+}
 
-    if((*tags)[i] == NULL)
-    {
-      *count = 0;
-      return;
-    }
+void id3v2_load_tags_from_file(FILE *file, id3v2_tag ***tags, int *count)
+{
+  id3v2_load_tags_from_file_with_options(file, tags, count, NULL);
+}
 
-    free(buffer);
+void id3v2_load_tags_from_file_with_options(FILE *file, id3v2_tag ***tags, int *count, id3v2_load_options *options)
+{
+  id3v2_io io;
 
+  if(file == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    *count = 0;
+    return;
   }
 
-  free(offsets);
+  id3v2_initialize_io_from_file(&io, file);
 
-  E_SUCCESS;
+  id3v2_load_tags_from_io_with_options(&io, tags, count, options);
+}
 
-  return;
+void id3v2_load_tags_from_fd(int fd, id3v2_tag ***tags, int *count)
+{
+  id3v2_load_tags_from_fd_with_options(fd, tags, count, NULL);
+}
+
+void id3v2_load_tags_from_fd_with_options(int fd, id3v2_tag ***tags, int *count, id3v2_load_options *options)
+{
+  id3v2_io io;
 
+  if(fd < 0)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    *count = 0;
+    return;
+  }
+
+  id3v2_initialize_io_from_fd(&io, fd);
+
+  id3v2_load_tags_from_io_with_options(&io, tags, count, options);
 }
 
-void id3v2_load_tags_from_buffer(char *buffer, int length, id3v2_tag ***tags, int *count)
+void id3v2_load_tags_from_buffer(char *buffer, size_t length, id3v2_tag ***tags, int *count)
 {
-  int i;
-  int *offsets;
+  id3v2_load_tags_from_buffer_with_options(buffer, length, tags, count, NULL);
+}
 
-  _find_header_offsets_in_buffer(buffer, length, &offsets, count);
+void id3v2_load_tags_from_buffer_with_options(char *buffer, size_t length, id3v2_tag ***tags, int *count, id3v2_load_options *options)
+{
+  int found_count;
+  int64_t *found_offsets;
+  id3v2_header *header;
+  int i;
+  int j;
+  int64_t next_offset;
+  int64_t *offsets;
+  char pointers = 0; // did any tag point to another one?
+  int64_t tag_end;
+
+  if(options != NULL && options->deep_scan)
+    _scan_header_offsets_in_buffer(buffer, length, &offsets, count);
+  else
+    _find_header_offsets_in_buffer(buffer, length, &offsets, count);
 
   if(*count == 0)
   {
@@ -200,11 +449,12 @@ void id3v2_load_tags_from_buffer(char *buffer, int length, id3v2_tag ***tags, in
     return;
   }
 
-  *tags= (id3v2_tag **)malloc((*count)*sizeof(id3v2_tag *));
+  *tags= (id3v2_tag **)_allocate((*count)*sizeof(id3v2_tag *));
 
   if(*tags == NULL)
   {
     E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    free(offsets);
     *count = 0;
     return;
   }
@@ -212,14 +462,52 @@ void id3v2_load_tags_from_buffer(char *buffer, int length, id3v2_tag ***tags, in
   for(i = 0; i < *count; i++)
   {
 
-    (*tags)[i]=id3v2_load_tag_from_buffer(buffer+offsets[i], length-offsets[i]);
+    (*tags)[i]=id3v2_load_tag_from_buffer_with_options(buffer+offsets[i], length-offsets[i], options);
 
     if((*tags)[i] == NULL)
     {
+      _free_tag_list(*tags, i);
+      free(offsets);
       *count = 0;
       return;
     }
 
+    // follow the pointer to the next tag, it may be anywhere in the buffer
+    next_offset = _get_next_tag_offset_from_tag((*tags)[i], offsets[i]);
+
+    if(next_offset >= 0)
+    {
+      pointers = 1;
+      header = next_offset > offsets[i] && (uint64_t)next_offset < length ?
+               _get_header_from_buffer(buffer+next_offset, length-next_offset) : NULL;
+      if(header != NULL)
+      {
+        free(header);
+        _add_header_offset(&offsets, count, next_offset);
+      }
+    }
+
+    // a single tag without pointers might still be followed by another one closely behind it
+    tag_end = offsets[0] + ID3V2_HEADER + (*tags)[0]->header->tag_size;
+    if(*count == 1 && !pointers && (options == NULL || !options->deep_scan) && (uint64_t)tag_end < length)
+    {
+      _scan_header_offsets_in_buffer(buffer+tag_end, length-tag_end < ID3V2_BOUNDED_SCAN ? length-tag_end : ID3V2_BOUNDED_SCAN, &found_offsets, &found_count);
+
+      for(j = 0; j < found_count; j++)
+        _add_header_offset(&offsets, count, tag_end + found_offsets[j]);
+
+      if(found_count > 0)
+        free(found_offsets);
+    }
+
+    if(!_resize_tag_list(tags, *count))
+    {
+      E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+      _free_tag_list(*tags, i + 1);
+      free(offsets);
+      *count = 0;
+      return;
+    }
   }
 
   free(offsets);
@@ -230,13 +518,220 @@ void id3v2_load_tags_from_buffer(char *buffer, int length, id3v2_tag ***tags, in
 
 }
 
-id3v2_tag* id3v2_load_tag_from_buffer(char *bytes, int length)
+// a frame of a tag being merged along with the key which tells it apart from frames with the same ID
+typedef struct
+{
+  id3v2_frame *frame;
+  char *key;
+  int key_size;
+} merge_entry;
+
+static void _free_merge_entries(merge_entry *entries, int count)
+{
+  int i;
+
+  for(i = 0; i < count; i++)
+    free(entries[i].key);
+
+  free(entries);
+}
+
+// returns the frames of the tag in their order with their keys, NULL if there's no memory for them
+static merge_entry *_get_merge_entries_of_tag(id3v2_tag *tag, int *count)
+{
+  merge_entry *entries;
+  id3v2_frame *frame;
+  int i;
+
+  for(*count = 0, frame = tag->frame; frame != NULL; frame = frame->next)
+    (*count)++;
+
+  entries = (merge_entry*)_allocate_zeroed(*count + 1, sizeof(merge_entry));
+
+  if(entries == NULL)
+    return NULL;
+
+  for(i = 0, frame = tag->frame; frame != NULL; i++, frame = frame->next)
+  {
+    entries[i].frame = frame;
+
+    if(!_get_unique_key_of_frame(frame, &entries[i].key, &entries[i].key_size))
+    {
+      _free_merge_entries(entries, i);
+      return NULL;
+    }
+  }
+
+  return entries;
+}
+
+// frames override each other if they have the same ID and, for frames which may occur several times, the same key
+static int _overrides_frame(merge_entry *entry, merge_entry *old_entry)
+{
+  return memcmp(entry->frame->id, old_entry->frame->id, ID3V2_FRAME_ID) == 0 &&
+         entry->key_size == old_entry->key_size &&
+         (entry->key_size == 0 || memcmp(entry->key, old_entry->key, entry->key_size) == 0);
+}
+
+// merges tags found in the same file in their order of appearance
+// frames of later tags replace the frames of the earlier tags with the same id, frames which may occur several times
+// like TXXX, COMM or APIC only those with the same key as well (see id3v2_patch_operation), other frames get appended
+// the frames are moved into the first tag, which gets returned, the other tags are left without frames
+id3v2_tag *id3v2_merge_tags(id3v2_tag **tags, int count)
+{
+  id3v2_frame *frame;
+  id3v2_frame *frames;
+  int i;
+  int j;
+  int k;
+  merge_entry *entries;
+  int entry_count;
+  id3v2_frame *next_frame;
+  merge_entry *old_entries;
+  int old_entry_count;
+  id3v2_tag *tag;
+
+  if(tags == NULL || count < 1 || tags[0] == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  tag = tags[0];
+
+  for(i = 1; i < count; i++)
+  {
+    if(tags[i] == NULL || id3v2_get_tag_version(tags[i]) != id3v2_get_tag_version(tag))
+      continue; // frames can't be moved between different versions
+
+    // all keys are found before anything is moved, so running out of memory leaves the tags as they are
+    old_entries = _get_merge_entries_of_tag(tag, &old_entry_count);
+    entries = _get_merge_entries_of_tag(tags[i], &entry_count);
+
+    if(old_entries == NULL || entries == NULL)
+    {
+      if(old_entries != NULL)
+        _free_merge_entries(old_entries, old_entry_count);
+      if(entries != NULL)
+        _free_merge_entries(entries, entry_count);
+      E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+      return NULL;
+    }
+
+    // drop everything which gets overridden first, since a tag may contain several frames with the same id and key
+    for(j = 0; j < old_entry_count; j++)
+    {
+      for(k = 0; k < entry_count && !_overrides_frame(&entries[k], &old_entries[j]); k++);
+
+      if(k < entry_count)
+      {
+        _detach_frame_from_tag(tag, old_entries[j].frame);
+        _free_frame(old_entries[j].frame);
+      }
+    }
+
+    _free_merge_entries(old_entries, old_entry_count);
+    _free_merge_entries(entries, entry_count);
+
+    frames = tags[i]->frame;
+    tags[i]->frame = NULL;
+
+    for(frame = frames; frame != NULL; frame = next_frame)
+    {
+      next_frame = frame->next;
+      frame->next = NULL;
+      if(memcmp(frame->id, "SEEK", ID3V2_FRAME_ID) == 0)
+      {
+        // pointers to other tags don't make sense anymore
+        _free_frame(frame);
+        continue;
+      }
+      frame->tag = tag;
+      id3v2_add_frame_to_tag(tag, frame);
+    }
+  }
+
+  // the first tag may point to the other tags as well
+  frame = id3v2_get_frame_from_tag(tag, "SEEK");
+  if(frame != NULL && count > 1)
+  {
+    _detach_frame_from_tag(tag, frame);
+    _free_frame(frame);
+  }
+
+  E_SUCCESS;
+
+  return tag;
+}
+
+// parses the frames found in size bytes into the tag, the first one which can't be read ends them
+void _parse_frames_into_tag(id3v2_tag *tag, char *bytes, int size, id3v2_load_options *options)
+{
+  char *c_bytes = bytes;
+  id3v2_frame *frame;
+  int64_t timer;
+
+  STATS_START_TIMER(timer);
+
+  while((bytes - c_bytes) < size)
+  {
+    frame=_parse_frame_from_tag(tag, bytes, size - (int)(bytes - c_bytes));
+    if(frame != NULL) // a frame was found
+    {
+      TRACE(frame, ID3V2_TRACE_FRAME, bytes - c_bytes, frame->size, frame->parsed, frame->id,
+            (unsigned char)frame->flags[0] << 8 | (unsigned char)frame->flags[1], -1);
+      bytes += frame->size + ID3V2_DECIDE_FRAME(frame->version, ID3V2_FRAME_ID2 + ID3V2_FRAME_SIZE2, ID3V2_FRAME);
+      if(frame->parsed) // and it got parsed
+      {
+        STATS_ADD(frames_parsed, 1);
+
+        // detect unsynchronization and reverse it if needed
+        // only 2.4 does it frame by frame, earlier tags got reversed as a whole when they were loaded
+        if(frame->version == ID3V2_4 &&
+           ((tag->header->flags&(1<<7))==(1<<7) ||
+            (frame->flags[1]&(1<<1))==(1<<1)))
+        {
+          _synchronize_frame(frame);
+        }
+
+        // deduplicate text contents if the caller provided a pool for them
+        if(options != NULL && options->intern_pool != NULL &&
+           (id3v2_get_frame_type(frame) == ID3V2_TEXT_FRAME ||
+            id3v2_get_frame_type(frame) == ID3V2_COMMENT_FRAME))
+          _intern_frame_data(options->intern_pool, frame);
+
+        // share identical pictures between tags
+        if(options != NULL && options->image_cache != NULL &&
+           id3v2_get_frame_type(frame) == ID3V2_APIC_FRAME)
+          _cache_picture_of_frame(options->image_cache, frame);
+      }
+      else
+      {
+        STATS_ADD(frames_unparsed, 1);
+        _detach_frame_from_tag(tag, frame);
+        _free_frame(frame);
+      }
+    }
+    else
+      break;
+  }
+
+  STATS_STOP_TIMER(frame_nanoseconds, timer);
+}
+
+id3v2_tag* id3v2_load_tag_from_buffer(char *bytes, size_t length)
+{
+    return id3v2_load_tag_from_buffer_with_options(bytes, length, NULL);
+}
+
+id3v2_tag* id3v2_load_tag_from_buffer_with_options(char *bytes, size_t length, id3v2_load_options *options)
 {
     // Declaration
-    char *c_bytes;
-    id3v2_frame *frame;
     id3v2_tag* tag;
     id3v2_header* tag_header;
+    int body_size;
+    char *synchronised = NULL;
+    char pending_ff = 0;
 
     // Initialization
     tag_header = _get_header_from_buffer(bytes, length);
@@ -247,7 +742,7 @@ id3v2_tag* id3v2_load_tag_from_buffer(char *bytes, int length)
       return NULL;
     }
 
-    if(length < tag_header->tag_size+10)
+    if(length < (size_t)tag_header->tag_size+10)
     {
         // Not enough bytes provided to parse completely.
         E_FAIL(ID3V2_ERROR_INSUFFICIENT_DATA);
@@ -278,38 +773,43 @@ id3v2_tag* id3v2_load_tag_from_buffer(char *bytes, int length)
 
     // move the bytes pointer to the correct position
     bytes+=10; // skip header
-    if(tag_header->extended_header_size)
-      // an extended header exists, so we skip it too
-      bytes+=tag_header->extended_header_size+4; // don't forget to skip the extended header size bytes too
+    body_size = tag_header->tag_size;
 
-    c_bytes = bytes;
-    
-    while((bytes - c_bytes) < tag_header->tag_size)
+    // before 2.4 the whole tag got unsynchronised, the extended header and the frame headers included,
+    // so the frame sizes only make sense once all of it got reversed
+    if(tag_header->major_version < 4 && (tag_header->flags&(1<<7))==(1<<7))
     {
-      frame=_parse_frame_from_tag(tag, bytes);
-      if(frame != NULL) // a frame was found
+      synchronised = (char*)_allocate(body_size > 0 ? body_size : 1);
+
+      if(synchronised == NULL)
       {
-        bytes += frame->size + 10;
-        if(frame->parsed) // and it got parsed
-        {
-          // detect unsynchronization and reverse it if needed
-          if(tag_header->flags&(1<<7)==(1<<7) ||
-             frame->flags[1]&(1<<1)==(1<<1))
-          {
-            _synchronize_frame(frame);
-          }
-        }
-        else
-        {
-          if(frame->data != NULL)
-            free(frame->data);
-          free(frame);
-        }
+        E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+        id3v2_free_tag(tag);
+        return NULL;
       }
-      else
-        break;
+
+      memcpy(synchronised, bytes, body_size);
+      body_size = _synchronize_buffer(synchronised, body_size, &pending_ff);
+      bytes = synchronised;
     }
 
+    if(tag_header->extended_header_size < 0 || tag_header->extended_header_size > body_size)
+    {
+        // the extended header doesn't fit into the tag
+        free(synchronised);
+        E_FAIL(ID3V2_ERROR_INCOMPATIBLE_TAG);
+        id3v2_free_tag(tag);
+        return NULL;
+    }
+
+    // an extended header exists, so we skip it too, its size bytes are already part of its size
+    bytes+=tag_header->extended_header_size;
+
+    _parse_frames_into_tag(tag, bytes, body_size - tag_header->extended_header_size, options);
+
+    // the frames got copies of their data
+    free(synchronised);
+
     E_SUCCESS;
 
     return tag;
@@ -0,0 +1,291 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+#define IMAGE_CACHE_INITIAL_BUCKETS 64 // needs to be a power of two
+
+struct id3v2_cached_image
+{
+  uint64_t digest;
+  int size;
+  int references; // guarded by the mutex of the cache
+  id3v2_image_cache *cache;
+  id3v2_cached_image *next; // next image in the same bucket
+  char data[];
+};
+
+// outlives id3v2_free_image_cache() until the last of its images got released, so releasing needs no other lock
+struct id3v2_image_cache
+{
+  id3v2_cached_image **buckets;
+  int bucket_count;
+  int count;
+  int closed; // id3v2_free_image_cache() got called
+  void *mutex;
+};
+
+static int _grow_image_cache(id3v2_image_cache *cache)
+{
+  id3v2_cached_image **buckets;
+  id3v2_cached_image *image;
+  id3v2_cached_image *next_image;
+  int bucket_count = cache->bucket_count * 2;
+  int i;
+
+  buckets = (id3v2_cached_image**)_allocate_zeroed(bucket_count, sizeof(id3v2_cached_image*));
+
+  if(buckets == NULL)
+    return 0;
+
+  for(i = 0; i < cache->bucket_count; i++)
+  {
+    for(image = cache->buckets[i]; image != NULL; image = next_image)
+    {
+      next_image = image->next;
+      image->next = buckets[image->digest & (bucket_count - 1)];
+      buckets[image->digest & (bucket_count - 1)] = image;
+    }
+  }
+
+  free(cache->buckets);
+  cache->buckets = buckets;
+  cache->bucket_count = bucket_count;
+
+  return 1;
+}
+
+id3v2_image_cache *id3v2_new_image_cache()
+{
+  id3v2_image_cache *cache = (id3v2_image_cache*)_allocate(sizeof(id3v2_image_cache));
+
+  if(cache == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  cache->buckets = (id3v2_cached_image**)_allocate_zeroed(IMAGE_CACHE_INITIAL_BUCKETS, sizeof(id3v2_cached_image*));
+  cache->mutex = _new_mutex();
+
+  if(cache->buckets == NULL || cache->mutex == NULL)
+  {
+    free(cache->buckets);
+    _free_mutex(cache->mutex);
+    free(cache);
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  cache->bucket_count = IMAGE_CACHE_INITIAL_BUCKETS;
+  cache->count = 0;
+  cache->closed = 0;
+
+  E_SUCCESS;
+
+  return cache;
+}
+
+static void _destroy_image_cache(id3v2_image_cache *cache)
+{
+  free(cache->buckets);
+  _free_mutex(cache->mutex);
+  free(cache);
+}
+
+// images still referenced by frames stay alive until their last frame releases them, the cache gets
+// destroyed along with the last of them
+void id3v2_free_image_cache(id3v2_image_cache *cache)
+{
+  int empty;
+
+  if(cache == NULL)
+    return;
+
+  _lock_mutex(cache->mutex);
+  cache->closed = 1;
+  empty = cache->count == 0;
+  _unlock_mutex(cache->mutex);
+
+  if(empty)
+    _destroy_image_cache(cache);
+
+  E_SUCCESS;
+}
+
+int id3v2_get_image_count_from_image_cache(id3v2_image_cache *cache)
+{
+  int count;
+
+  if(cache == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  _lock_mutex(cache->mutex);
+  count = cache->count;
+  _unlock_mutex(cache->mutex);
+
+  E_SUCCESS;
+
+  return count;
+}
+
+// moves the picture payload of an APIC frame into the cache, so identical pictures are stored only once
+// returns 1 if the frame now references a cached image, 0 otherwise
+int _cache_picture_of_frame(id3v2_image_cache *cache, id3v2_frame *frame)
+{
+  char *data;
+  uint64_t digest;
+  id3v2_cached_image *image;
+  char *mime_type;
+  char *picture;
+  int picture_size;
+  int prefix_size;
+  int slot;
+
+  if(cache == NULL || frame == NULL || frame->image != NULL || frame->interned)
+    return 0;
+
+  id3v2_get_picture_from_frame(frame, &picture, &picture_size, &mime_type);
+
+  if(E_GET != ID3V2_OK || picture_size <= 0)
+    return 0;
+
+  prefix_size = picture - frame->data;
+  digest = _xxhash64_buffer(picture, picture_size, 0);
+
+  _lock_mutex(cache->mutex);
+
+  slot = digest & (cache->bucket_count - 1);
+
+  for(image = cache->buckets[slot]; image != NULL; image = image->next)
+  {
+    if(image->digest == digest && image->size == picture_size && memcmp(image->data, picture, picture_size) == 0)
+      break;
+  }
+
+  if(image == NULL)
+  {
+    if(cache->count >= cache->bucket_count)
+    {
+      _grow_image_cache(cache); // the old table keeps working if this fails
+      slot = digest & (cache->bucket_count - 1);
+    }
+
+    image = (id3v2_cached_image*)_allocate(sizeof(id3v2_cached_image) + picture_size);
+
+    if(image == NULL)
+    {
+      _unlock_mutex(cache->mutex);
+      return 0;
+    }
+
+    image->digest = digest;
+    image->size = picture_size;
+    image->references = 0;
+    image->cache = cache;
+    memcpy(image->data, picture, picture_size);
+
+    image->next = cache->buckets[slot];
+    cache->buckets[slot] = image;
+    cache->count++;
+  }
+
+  image->references++;
+
+  _unlock_mutex(cache->mutex);
+
+  // the frame only keeps the bytes in front of the picture itself
+  data = (char*)_reallocate(frame->data, prefix_size > 0 ? prefix_size : 1);
+  if(data != NULL)
+    frame->data = data;
+
+  frame->size = prefix_size;
+  frame->image = image;
+
+  return 1;
+}
+
+void _get_picture_from_cached_image(id3v2_cached_image *image, char **picture, int *size)
+{
+  *picture = image->data;
+  *size = image->size;
+}
+
+void _release_cached_image(id3v2_cached_image *image)
+{
+  id3v2_image_cache *cache;
+  id3v2_cached_image **link;
+  int destroy;
+
+  if(image == NULL)
+    return;
+
+  cache = image->cache;
+
+  _lock_mutex(cache->mutex);
+
+  if(--image->references > 0)
+  {
+    _unlock_mutex(cache->mutex);
+    return;
+  }
+
+  for(link = &cache->buckets[image->digest & (cache->bucket_count - 1)]; *link != NULL; link = &(*link)->next)
+  {
+    if(*link == image)
+    {
+      *link = image->next;
+      cache->count--;
+      break;
+    }
+  }
+
+  // the last image of a closed cache takes the cache with it
+  destroy = cache->closed && cache->count == 0;
+
+  _unlock_mutex(cache->mutex);
+
+  free(image);
+
+  if(destroy)
+    _destroy_image_cache(cache);
+}
+
+uint64_t id3v2_get_picture_digest_from_frame(id3v2_frame *frame)
+{
+  char *mime_type;
+  char *picture;
+  int picture_size;
+
+  if(frame == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  if(frame->image != NULL)
+  {
+    E_SUCCESS;
+    return frame->image->digest;
+  }
+
+  id3v2_get_picture_from_frame(frame, &picture, &picture_size, &mime_type);
+
+  if(E_GET != ID3V2_OK)
+    return 0;
+
+  return _xxhash64_buffer(picture, picture_size, 0);
+}
@@ -0,0 +1,216 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+#define FRAME_INDEX_KEY 256 // keys up to this size get converted on the stack
+
+typedef struct
+{
+  uint64_t hash;
+  id3v2_frame *frame;
+} frame_index_entry;
+
+struct id3v2_frame_index
+{
+  frame_index_entry *entries;
+  int capacity; // a power of two, at least twice the amount of frames
+};
+
+// the description of TXXX and WXXX frames, the owner of PRIV and UFID frames
+static id3v2_text_view *_get_key_of_frame(id3v2_frame *frame, int kind)
+{
+  id3v2_user_text_content *user_text;
+  id3v2_private_content *private_data;
+  id3v2_unique_file_identifier_content *unique_file_identifier;
+
+  switch(kind)
+  {
+    case ID3V2_KIND_TXXX:
+    case ID3V2_KIND_WXXX:
+      user_text = id3v2_get_user_text_content_from_frame(frame);
+      return user_text != NULL ? &user_text->description : NULL;
+    case ID3V2_KIND_PRIV:
+      private_data = id3v2_get_private_content_from_frame(frame);
+      return private_data != NULL ? &private_data->owner : NULL;
+    case ID3V2_KIND_UFID:
+      unique_file_identifier = id3v2_get_unique_file_identifier_content_from_frame(frame);
+      return unique_file_identifier != NULL ? &unique_file_identifier->owner : NULL;
+    default:
+      return NULL;
+  }
+}
+
+// hashes kind and UTF-8 key together, so equal keys of different kinds don't meet
+static uint64_t _hash_frame_key(int kind, const char *key, int size)
+{
+  return _xxhash64_buffer(key, size, (uint64_t)kind);
+}
+
+// converts the key of the frame to UTF-8 and compares it with key, hashing it on the way if asked to
+// returns 1 if both match, 0 if they don't and -1 if the frame has no key
+static int _compare_key_of_frame(id3v2_frame *frame, int kind, const char *key, int size, uint64_t *hash)
+{
+  char buffer[FRAME_INDEX_KEY * 2];
+  char *utf8 = buffer;
+  id3v2_text_view *view = _get_key_of_frame(frame, kind);
+  int length;
+  int result;
+
+  if(view == NULL)
+    return -1;
+
+  if(view->size > FRAME_INDEX_KEY)
+  {
+    utf8 = (char*)_allocate(view->size * 2);
+    if(utf8 == NULL)
+      return -1;
+  }
+
+  length = _convert_text_to_utf8(view->text, view->size, view->encoding, utf8);
+
+  if(hash != NULL)
+    *hash = _hash_frame_key(kind, utf8, length);
+
+  result = key != NULL && length == size && memcmp(utf8, key, size) == 0;
+
+  if(utf8 != buffer)
+    free(utf8);
+
+  return result;
+}
+
+static int _is_keyed_kind(int kind)
+{
+  return kind == ID3V2_KIND_TXXX || kind == ID3V2_KIND_WXXX || kind == ID3V2_KIND_PRIV || kind == ID3V2_KIND_UFID;
+}
+
+static id3v2_frame_index *_build_frame_index(id3v2_tag *tag)
+{
+  id3v2_frame_index *index;
+  id3v2_frame *frame;
+  int count = 0;
+  uint64_t hash;
+  int kind;
+  int slot;
+
+  for(frame = tag->frame; frame != NULL; frame = frame->next)
+    count += _is_keyed_kind(_get_frame_kind_from_id(frame->id, frame->version));
+
+  index = (id3v2_frame_index*)_allocate(sizeof(id3v2_frame_index));
+
+  if(index == NULL)
+    return NULL;
+
+  for(index->capacity = 4; index->capacity < count * 2; index->capacity *= 2);
+
+  index->entries = (frame_index_entry*)_allocate_zeroed(index->capacity, sizeof(frame_index_entry));
+
+  if(index->entries == NULL)
+  {
+    free(index);
+    return NULL;
+  }
+
+  for(frame = tag->frame; frame != NULL; frame = frame->next)
+  {
+    kind = _get_frame_kind_from_id(frame->id, frame->version);
+
+    if(!_is_keyed_kind(kind) || _compare_key_of_frame(frame, kind, NULL, 0, &hash) < 0)
+      continue;
+
+    // the first frame with a key wins, like a walk through the frames would find it
+    for(slot = (int)(hash & (index->capacity - 1)); index->entries[slot].frame != NULL; slot = (slot + 1) & (index->capacity - 1));
+
+    index->entries[slot].hash = hash;
+    index->entries[slot].frame = frame;
+  }
+
+  return index;
+}
+
+// drops the indexes, the next keyed or chapter lookup builds new ones
+void _free_frame_index_of_tag(id3v2_tag *tag)
+{
+  _free_chapter_index_of_tag(tag);
+
+  if(tag->index == NULL)
+    return;
+
+  free(tag->index->entries);
+  free(tag->index);
+  tag->index = NULL;
+}
+
+// returns the first frame of the kind whose key matches the UTF-8 string key
+static id3v2_frame *_get_keyed_frame_from_tag(id3v2_tag *tag, int kind, const char *key)
+{
+  uint64_t hash;
+  int size;
+  int slot;
+  id3v2_frame_index *index;
+
+  if(tag == NULL || key == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  if(tag->index == NULL)
+  {
+    tag->index = _build_frame_index(tag);
+
+    if(tag->index == NULL)
+    {
+      E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+      return NULL;
+    }
+  }
+
+  index = tag->index;
+  size = (int)strlen(key);
+  hash = _hash_frame_key(kind, key, size);
+
+  for(slot = (int)(hash & (index->capacity - 1)); index->entries[slot].frame != NULL; slot = (slot + 1) & (index->capacity - 1))
+  {
+    if(index->entries[slot].hash == hash && _compare_key_of_frame(index->entries[slot].frame, kind, key, size, NULL) == 1)
+    {
+      E_SUCCESS;
+      return index->entries[slot].frame;
+    }
+  }
+
+  E_FAIL(ID3V2_ERROR_NOT_FOUND);
+
+  return NULL;
+}
+
+// the TXXX frame with the given description, TXX for v2.2 tags
+id3v2_frame *id3v2_get_user_text_frame_from_tag(id3v2_tag *tag, const char *description)
+{
+  return _get_keyed_frame_from_tag(tag, ID3V2_KIND_TXXX, description);
+}
+
+id3v2_frame *id3v2_get_user_url_frame_from_tag(id3v2_tag *tag, const char *description)
+{
+  return _get_keyed_frame_from_tag(tag, ID3V2_KIND_WXXX, description);
+}
+
+id3v2_frame *id3v2_get_private_frame_from_tag(id3v2_tag *tag, const char *owner)
+{
+  return _get_keyed_frame_from_tag(tag, ID3V2_KIND_PRIV, owner);
+}
+
+id3v2_frame *id3v2_get_unique_file_identifier_frame_from_tag(id3v2_tag *tag, const char *owner)
+{
+  return _get_keyed_frame_from_tag(tag, ID3V2_KIND_UFID, owner);
+}
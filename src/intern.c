@@ -0,0 +1,249 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+#define INTERN_POOL_INITIAL_CAPACITY 256 // needs to be a power of two
+
+typedef struct
+{
+  unsigned int hash;
+  int size;
+  char data[];
+} intern_entry;
+
+struct id3v2_intern_pool
+{
+  intern_entry **entries; // open addressing table, NULL marks a free slot
+  int capacity;
+  int count;
+  void *mutex;
+};
+
+static unsigned int _hash_buffer(const char *buffer, int size)
+{
+  // FNV-1a, good enough for the short strings found in text frames
+  unsigned int hash = 2166136261u;
+  int i;
+
+  for(i = 0; i < size; i++)
+  {
+    hash ^= (unsigned char)buffer[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+static int _grow_intern_pool(id3v2_intern_pool *pool)
+{
+  intern_entry **entries;
+  int capacity = pool->capacity * 2;
+  int i;
+  int slot;
+
+  entries = (intern_entry**)_allocate_zeroed(capacity, sizeof(intern_entry*));
+
+  if(entries == NULL)
+    return 0;
+
+  for(i = 0; i < pool->capacity; i++)
+  {
+    if(pool->entries[i] == NULL)
+      continue;
+
+    slot = pool->entries[i]->hash & (capacity - 1);
+    while(entries[slot] != NULL)
+      slot = (slot + 1) & (capacity - 1);
+    entries[slot] = pool->entries[i];
+  }
+
+  free(pool->entries);
+  pool->entries = entries;
+  pool->capacity = capacity;
+
+  return 1;
+}
+
+id3v2_intern_pool *id3v2_new_intern_pool()
+{
+  id3v2_intern_pool *pool = (id3v2_intern_pool*)_allocate(sizeof(id3v2_intern_pool));
+
+  if(pool == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  pool->entries = (intern_entry**)_allocate_zeroed(INTERN_POOL_INITIAL_CAPACITY, sizeof(intern_entry*));
+  pool->mutex = _new_mutex();
+
+  if(pool->entries == NULL || pool->mutex == NULL)
+  {
+    free(pool->entries);
+    _free_mutex(pool->mutex);
+    free(pool);
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  pool->capacity = INTERN_POOL_INITIAL_CAPACITY;
+  pool->count = 0;
+
+  E_SUCCESS;
+
+  return pool;
+}
+
+void id3v2_free_intern_pool(id3v2_intern_pool *pool)
+{
+  int i;
+
+  if(pool == NULL)
+    return;
+
+  for(i = 0; i < pool->capacity; i++)
+    free(pool->entries[i]);
+
+  free(pool->entries);
+  _free_mutex(pool->mutex);
+  free(pool);
+
+  E_SUCCESS;
+}
+
+const char *id3v2_intern_buffer_in_pool(id3v2_intern_pool *pool, const char *buffer, int size)
+{
+  intern_entry *entry;
+  unsigned int hash;
+  int slot;
+
+  if(pool == NULL || buffer == NULL || size < 0)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  hash = _hash_buffer(buffer, size);
+
+  _lock_mutex(pool->mutex);
+
+  slot = hash & (pool->capacity - 1);
+
+  while((entry = pool->entries[slot]) != NULL)
+  {
+    if(entry->hash == hash && entry->size == size && memcmp(entry->data, buffer, size) == 0)
+    {
+      _unlock_mutex(pool->mutex);
+      E_SUCCESS;
+      return entry->data;
+    }
+    slot = (slot + 1) & (pool->capacity - 1);
+  }
+
+  // not interned yet, keep the load factor below 3/4 before inserting
+  if((pool->count + 1) * 4 > pool->capacity * 3)
+  {
+    if(!_grow_intern_pool(pool))
+    {
+      _unlock_mutex(pool->mutex);
+      E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+      return NULL;
+    }
+
+    slot = hash & (pool->capacity - 1);
+    while(pool->entries[slot] != NULL)
+      slot = (slot + 1) & (pool->capacity - 1);
+  }
+
+  entry = (intern_entry*)_allocate(sizeof(intern_entry) + size);
+
+  if(entry == NULL)
+  {
+    _unlock_mutex(pool->mutex);
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  entry->hash = hash;
+  entry->size = size;
+  memcpy(entry->data, buffer, size);
+
+  pool->entries[slot] = entry;
+  pool->count++;
+
+  _unlock_mutex(pool->mutex);
+
+  E_SUCCESS;
+
+  return entry->data;
+}
+
+int id3v2_get_entry_count_from_intern_pool(id3v2_intern_pool *pool)
+{
+  int count;
+
+  if(pool == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  _lock_mutex(pool->mutex);
+  count = pool->count;
+  _unlock_mutex(pool->mutex);
+
+  E_SUCCESS;
+
+  return count;
+}
+
+// replaces the private data of a frame with the interned copy
+// returns 1 if the frame got interned, 0 otherwise
+int _intern_frame_data(id3v2_intern_pool *pool, id3v2_frame *frame)
+{
+  const char *interned;
+
+  if(pool == NULL || frame == NULL || frame->data == NULL || frame->interned)
+    return 0;
+
+  interned = id3v2_intern_buffer_in_pool(pool, frame->data, frame->size);
+
+  if(interned == NULL)
+    return 0;
+
+  free(frame->data);
+  frame->data = (char*)interned;
+  frame->interned = 1;
+
+  return 1;
+}
+
+const char *id3v2_get_interned_data_from_frame(id3v2_frame *frame)
+{
+  if(frame == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  if(!frame->interned)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  E_SUCCESS;
+
+  return frame->data;
+}
@@ -0,0 +1,130 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+static int _read_at_file(void *context, int64_t offset, char *buffer, int size)
+{
+  FILE *file = (FILE*)context;
+
+  if(_seek_in_file(file, offset, SEEK_SET) != 0)
+    return 0;
+
+  return (int)fread(buffer, 1, size, file);
+}
+
+static int64_t _get_size_of_file(void *context)
+{
+  return _get_length_of_file((FILE*)context);
+}
+
+static int _read_at_fd(void *context, int64_t offset, char *buffer, int size)
+{
+  return _read_from_fd((int)(intptr_t)context, offset, buffer, size);
+}
+
+static int64_t _get_size_of_fd(void *context)
+{
+  return _get_length_of_fd((int)(intptr_t)context);
+}
+
+static int _read_at_buffer(void *context, int64_t offset, char *buffer, int size)
+{
+  io_buffer *source = (io_buffer*)context;
+
+  if(offset < 0 || (uint64_t)offset >= source->length)
+    return 0;
+
+  if((uint64_t)size > source->length - offset)
+    size = (int)(source->length - offset);
+
+  memcpy(buffer, source->buffer + offset, size);
+
+  return size;
+}
+
+static int64_t _get_size_of_buffer(void *context)
+{
+  return (int64_t)((io_buffer*)context)->length;
+}
+
+void id3v2_initialize_io_from_file(id3v2_io *io, FILE *file)
+{
+  if(io == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return;
+  }
+
+  io->context = file;
+  io->read_at = _read_at_file;
+  io->size = _get_size_of_file;
+  io->hint = NULL;
+
+  E_SUCCESS;
+}
+
+// every read is a positional one, so an io created for a descriptor may be used by several threads
+void id3v2_initialize_io_from_fd(id3v2_io *io, int fd)
+{
+  if(io == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return;
+  }
+
+  io->context = (void*)(intptr_t)fd;
+  io->read_at = _read_at_fd;
+  io->size = _get_size_of_fd;
+  io->hint = NULL;
+
+  E_SUCCESS;
+}
+
+void _initialize_io_from_buffer(id3v2_io *io, io_buffer *buffer)
+{
+  io->context = buffer;
+  io->read_at = _read_at_buffer;
+  io->size = _get_size_of_buffer;
+  io->hint = NULL;
+}
+
+int _read_from_io(id3v2_io *io, int64_t offset, char *buffer, int size)
+{
+  int read_size;
+  int64_t start = 0;
+
+  if(size <= 0 || offset < 0)
+    return 0;
+
+  if(TRACE_ENABLED(read))
+    start = _get_monotonic_nanoseconds();
+
+  read_size = io->read_at(io->context, offset, buffer, size);
+
+  TRACE(read, ID3V2_TRACE_READ, offset, size, read_size > 0 ? read_size : 0, NULL, -1,
+        start != 0 ? _get_monotonic_nanoseconds() - start : -1);
+
+  return read_size > 0 ? read_size : 0;
+}
+
+int64_t _get_size_of_io(id3v2_io *io)
+{
+  return io->size(io->context);
+}
+
+void _hint_io(id3v2_io *io, int64_t offset, int64_t size)
+{
+  if(io->hint != NULL && size > 0)
+    io->hint(io->context, offset, size);
+}
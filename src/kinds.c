@@ -0,0 +1,329 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+#define FRAME_ID_LETTER 1
+#define FRAME_ID_DIGIT 2
+
+// multiplier of the perfect hash, chosen together with the tables below so no two IDs share a slot
+#define FRAME_KIND_MULTIPLIER 0x52e6b439u
+
+typedef struct
+{
+  char id[ID3V2_FRAME_ID + 1];
+  unsigned char kind;
+  signed char type; // what id3v2_get_frame_type() returns for it
+} frame_kind_entry;
+
+// the letters and digits allowed in frame IDs, the same in every locale
+static const unsigned char frame_id_characters[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0,
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+// every ID of v2.2, v2.3 and v2.4 along with the chapter frames and the ones iTunes writes
+// v2.2 IDs share the kind of the frame which replaced them
+static const frame_kind_entry frame_kinds[] = {
+  { "AENC", ID3V2_KIND_AENC, ID3V2_INVALID_FRAME },
+  { "APIC", ID3V2_KIND_APIC, ID3V2_APIC_FRAME },
+  { "COMM", ID3V2_KIND_COMM, ID3V2_COMMENT_FRAME },
+  { "COMR", ID3V2_KIND_COMR, ID3V2_INVALID_FRAME },
+  { "ENCR", ID3V2_KIND_ENCR, ID3V2_INVALID_FRAME },
+  { "EQUA", ID3V2_KIND_EQUA, ID3V2_INVALID_FRAME },
+  { "ETCO", ID3V2_KIND_ETCO, ID3V2_INVALID_FRAME },
+  { "GEOB", ID3V2_KIND_GEOB, ID3V2_INVALID_FRAME },
+  { "GRID", ID3V2_KIND_GRID, ID3V2_INVALID_FRAME },
+  { "IPLS", ID3V2_KIND_IPLS, ID3V2_INVALID_FRAME },
+  { "LINK", ID3V2_KIND_LINK, ID3V2_INVALID_FRAME },
+  { "MCDI", ID3V2_KIND_MCDI, ID3V2_INVALID_FRAME },
+  { "MLLT", ID3V2_KIND_MLLT, ID3V2_INVALID_FRAME },
+  { "OWNE", ID3V2_KIND_OWNE, ID3V2_INVALID_FRAME },
+  { "PRIV", ID3V2_KIND_PRIV, ID3V2_INVALID_FRAME },
+  { "PCNT", ID3V2_KIND_PCNT, ID3V2_INVALID_FRAME },
+  { "POPM", ID3V2_KIND_POPM, ID3V2_INVALID_FRAME },
+  { "POSS", ID3V2_KIND_POSS, ID3V2_INVALID_FRAME },
+  { "RBUF", ID3V2_KIND_RBUF, ID3V2_INVALID_FRAME },
+  { "RVAD", ID3V2_KIND_RVAD, ID3V2_INVALID_FRAME },
+  { "RVRB", ID3V2_KIND_RVRB, ID3V2_INVALID_FRAME },
+  { "SYLT", ID3V2_KIND_SYLT, ID3V2_INVALID_FRAME },
+  { "SYTC", ID3V2_KIND_SYTC, ID3V2_INVALID_FRAME },
+  { "TALB", ID3V2_KIND_TALB, ID3V2_TEXT_FRAME },
+  { "TBPM", ID3V2_KIND_TBPM, ID3V2_TEXT_FRAME },
+  { "TCOM", ID3V2_KIND_TCOM, ID3V2_TEXT_FRAME },
+  { "TCON", ID3V2_KIND_TCON, ID3V2_TEXT_FRAME },
+  { "TCOP", ID3V2_KIND_TCOP, ID3V2_TEXT_FRAME },
+  { "TDAT", ID3V2_KIND_TDAT, ID3V2_TEXT_FRAME },
+  { "TDLY", ID3V2_KIND_TDLY, ID3V2_TEXT_FRAME },
+  { "TENC", ID3V2_KIND_TENC, ID3V2_TEXT_FRAME },
+  { "TEXT", ID3V2_KIND_TEXT, ID3V2_TEXT_FRAME },
+  { "TFLT", ID3V2_KIND_TFLT, ID3V2_TEXT_FRAME },
+  { "TIME", ID3V2_KIND_TIME, ID3V2_TEXT_FRAME },
+  { "TIT1", ID3V2_KIND_TIT1, ID3V2_TEXT_FRAME },
+  { "TIT2", ID3V2_KIND_TIT2, ID3V2_TEXT_FRAME },
+  { "TIT3", ID3V2_KIND_TIT3, ID3V2_TEXT_FRAME },
+  { "TKEY", ID3V2_KIND_TKEY, ID3V2_TEXT_FRAME },
+  { "TLAN", ID3V2_KIND_TLAN, ID3V2_TEXT_FRAME },
+  { "TLEN", ID3V2_KIND_TLEN, ID3V2_TEXT_FRAME },
+  { "TMED", ID3V2_KIND_TMED, ID3V2_TEXT_FRAME },
+  { "TOAL", ID3V2_KIND_TOAL, ID3V2_TEXT_FRAME },
+  { "TOFN", ID3V2_KIND_TOFN, ID3V2_TEXT_FRAME },
+  { "TOLY", ID3V2_KIND_TOLY, ID3V2_TEXT_FRAME },
+  { "TOPE", ID3V2_KIND_TOPE, ID3V2_TEXT_FRAME },
+  { "TORY", ID3V2_KIND_TORY, ID3V2_TEXT_FRAME },
+  { "TOWN", ID3V2_KIND_TOWN, ID3V2_TEXT_FRAME },
+  { "TPE1", ID3V2_KIND_TPE1, ID3V2_TEXT_FRAME },
+  { "TPE2", ID3V2_KIND_TPE2, ID3V2_TEXT_FRAME },
+  { "TPE3", ID3V2_KIND_TPE3, ID3V2_TEXT_FRAME },
+  { "TPE4", ID3V2_KIND_TPE4, ID3V2_TEXT_FRAME },
+  { "TPOS", ID3V2_KIND_TPOS, ID3V2_TEXT_FRAME },
+  { "TPUB", ID3V2_KIND_TPUB, ID3V2_TEXT_FRAME },
+  { "TRCK", ID3V2_KIND_TRCK, ID3V2_TEXT_FRAME },
+  { "TRDA", ID3V2_KIND_TRDA, ID3V2_TEXT_FRAME },
+  { "TRSN", ID3V2_KIND_TRSN, ID3V2_TEXT_FRAME },
+  { "TRSO", ID3V2_KIND_TRSO, ID3V2_TEXT_FRAME },
+  { "TSIZ", ID3V2_KIND_TSIZ, ID3V2_TEXT_FRAME },
+  { "TSRC", ID3V2_KIND_TSRC, ID3V2_TEXT_FRAME },
+  { "TSSE", ID3V2_KIND_TSSE, ID3V2_TEXT_FRAME },
+  { "TYER", ID3V2_KIND_TYER, ID3V2_TEXT_FRAME },
+  { "TXXX", ID3V2_KIND_TXXX, ID3V2_TEXT_FRAME },
+  { "UFID", ID3V2_KIND_UFID, ID3V2_INVALID_FRAME },
+  { "USER", ID3V2_KIND_USER, ID3V2_INVALID_FRAME },
+  { "USLT", ID3V2_KIND_USLT, ID3V2_INVALID_FRAME },
+  { "WCOM", ID3V2_KIND_WCOM, ID3V2_URL_FRAME },
+  { "WCOP", ID3V2_KIND_WCOP, ID3V2_URL_FRAME },
+  { "WOAF", ID3V2_KIND_WOAF, ID3V2_URL_FRAME },
+  { "WOAR", ID3V2_KIND_WOAR, ID3V2_URL_FRAME },
+  { "WOAS", ID3V2_KIND_WOAS, ID3V2_URL_FRAME },
+  { "WORS", ID3V2_KIND_WORS, ID3V2_URL_FRAME },
+  { "WPAY", ID3V2_KIND_WPAY, ID3V2_URL_FRAME },
+  { "WPUB", ID3V2_KIND_WPUB, ID3V2_URL_FRAME },
+  { "WXXX", ID3V2_KIND_WXXX, ID3V2_URL_FRAME },
+  { "ASPI", ID3V2_KIND_ASPI, ID3V2_INVALID_FRAME },
+  { "EQU2", ID3V2_KIND_EQU2, ID3V2_INVALID_FRAME },
+  { "RVA2", ID3V2_KIND_RVA2, ID3V2_INVALID_FRAME },
+  { "SEEK", ID3V2_KIND_SEEK, ID3V2_INVALID_FRAME },
+  { "SIGN", ID3V2_KIND_SIGN, ID3V2_INVALID_FRAME },
+  { "TDEN", ID3V2_KIND_TDEN, ID3V2_TEXT_FRAME },
+  { "TDOR", ID3V2_KIND_TDOR, ID3V2_TEXT_FRAME },
+  { "TDRC", ID3V2_KIND_TDRC, ID3V2_TEXT_FRAME },
+  { "TDRL", ID3V2_KIND_TDRL, ID3V2_TEXT_FRAME },
+  { "TDTG", ID3V2_KIND_TDTG, ID3V2_TEXT_FRAME },
+  { "TIPL", ID3V2_KIND_TIPL, ID3V2_TEXT_FRAME },
+  { "TMCL", ID3V2_KIND_TMCL, ID3V2_TEXT_FRAME },
+  { "TMOO", ID3V2_KIND_TMOO, ID3V2_TEXT_FRAME },
+  { "TPRO", ID3V2_KIND_TPRO, ID3V2_TEXT_FRAME },
+  { "TSOA", ID3V2_KIND_TSOA, ID3V2_TEXT_FRAME },
+  { "TSOP", ID3V2_KIND_TSOP, ID3V2_TEXT_FRAME },
+  { "TSOT", ID3V2_KIND_TSOT, ID3V2_TEXT_FRAME },
+  { "TSST", ID3V2_KIND_TSST, ID3V2_TEXT_FRAME },
+  { "CHAP", ID3V2_KIND_CHAP, ID3V2_INVALID_FRAME },
+  { "CTOC", ID3V2_KIND_CTOC, ID3V2_INVALID_FRAME },
+  { "GRP1", ID3V2_KIND_GRP1, ID3V2_INVALID_FRAME },
+  { "MVIN", ID3V2_KIND_MVIN, ID3V2_INVALID_FRAME },
+  { "MVNM", ID3V2_KIND_MVNM, ID3V2_INVALID_FRAME },
+  { "PCST", ID3V2_KIND_PCST, ID3V2_INVALID_FRAME },
+  { "TCAT", ID3V2_KIND_TCAT, ID3V2_TEXT_FRAME },
+  { "TCMP", ID3V2_KIND_TCMP, ID3V2_TEXT_FRAME },
+  { "TDES", ID3V2_KIND_TDES, ID3V2_TEXT_FRAME },
+  { "TGID", ID3V2_KIND_TGID, ID3V2_TEXT_FRAME },
+  { "TKWD", ID3V2_KIND_TKWD, ID3V2_TEXT_FRAME },
+  { "TSO2", ID3V2_KIND_TSO2, ID3V2_TEXT_FRAME },
+  { "TSOC", ID3V2_KIND_TSOC, ID3V2_TEXT_FRAME },
+  { "WFED", ID3V2_KIND_WFED, ID3V2_URL_FRAME },
+  { "BUF", ID3V2_KIND_RBUF, ID3V2_INVALID_FRAME },
+  { "CNT", ID3V2_KIND_PCNT, ID3V2_INVALID_FRAME },
+  { "COM", ID3V2_KIND_COMM, ID3V2_COMMENT_FRAME },
+  { "CRA", ID3V2_KIND_AENC, ID3V2_INVALID_FRAME },
+  { "CRM", ID3V2_KIND_CRM, ID3V2_INVALID_FRAME },
+  { "EQU", ID3V2_KIND_EQUA, ID3V2_INVALID_FRAME },
+  { "ETC", ID3V2_KIND_ETCO, ID3V2_INVALID_FRAME },
+  { "GEO", ID3V2_KIND_GEOB, ID3V2_INVALID_FRAME },
+  { "IPL", ID3V2_KIND_IPLS, ID3V2_INVALID_FRAME },
+  { "LNK", ID3V2_KIND_LINK, ID3V2_INVALID_FRAME },
+  { "MCI", ID3V2_KIND_MCDI, ID3V2_INVALID_FRAME },
+  { "MLL", ID3V2_KIND_MLLT, ID3V2_INVALID_FRAME },
+  { "PIC", ID3V2_KIND_APIC, ID3V2_APIC_FRAME },
+  { "POP", ID3V2_KIND_POPM, ID3V2_INVALID_FRAME },
+  { "REV", ID3V2_KIND_RVRB, ID3V2_INVALID_FRAME },
+  { "RVA", ID3V2_KIND_RVAD, ID3V2_INVALID_FRAME },
+  { "SLT", ID3V2_KIND_SYLT, ID3V2_INVALID_FRAME },
+  { "STC", ID3V2_KIND_SYTC, ID3V2_INVALID_FRAME },
+  { "TAL", ID3V2_KIND_TALB, ID3V2_TEXT_FRAME },
+  { "TBP", ID3V2_KIND_TBPM, ID3V2_TEXT_FRAME },
+  { "TCM", ID3V2_KIND_TCOM, ID3V2_TEXT_FRAME },
+  { "TCO", ID3V2_KIND_TCON, ID3V2_TEXT_FRAME },
+  { "TCR", ID3V2_KIND_TCOP, ID3V2_TEXT_FRAME },
+  { "TDA", ID3V2_KIND_TDAT, ID3V2_TEXT_FRAME },
+  { "TDY", ID3V2_KIND_TDLY, ID3V2_TEXT_FRAME },
+  { "TEN", ID3V2_KIND_TENC, ID3V2_TEXT_FRAME },
+  { "TFT", ID3V2_KIND_TFLT, ID3V2_TEXT_FRAME },
+  { "TIM", ID3V2_KIND_TIME, ID3V2_TEXT_FRAME },
+  { "TKE", ID3V2_KIND_TKEY, ID3V2_TEXT_FRAME },
+  { "TLA", ID3V2_KIND_TLAN, ID3V2_TEXT_FRAME },
+  { "TLE", ID3V2_KIND_TLEN, ID3V2_TEXT_FRAME },
+  { "TMT", ID3V2_KIND_TMED, ID3V2_TEXT_FRAME },
+  { "TOA", ID3V2_KIND_TOPE, ID3V2_TEXT_FRAME },
+  { "TOF", ID3V2_KIND_TOFN, ID3V2_TEXT_FRAME },
+  { "TOL", ID3V2_KIND_TOLY, ID3V2_TEXT_FRAME },
+  { "TOR", ID3V2_KIND_TORY, ID3V2_TEXT_FRAME },
+  { "TOT", ID3V2_KIND_TOAL, ID3V2_TEXT_FRAME },
+  { "TP1", ID3V2_KIND_TPE1, ID3V2_TEXT_FRAME },
+  { "TP2", ID3V2_KIND_TPE2, ID3V2_TEXT_FRAME },
+  { "TP3", ID3V2_KIND_TPE3, ID3V2_TEXT_FRAME },
+  { "TP4", ID3V2_KIND_TPE4, ID3V2_TEXT_FRAME },
+  { "TPA", ID3V2_KIND_TPOS, ID3V2_TEXT_FRAME },
+  { "TPB", ID3V2_KIND_TPUB, ID3V2_TEXT_FRAME },
+  { "TRC", ID3V2_KIND_TSRC, ID3V2_TEXT_FRAME },
+  { "TRD", ID3V2_KIND_TRDA, ID3V2_TEXT_FRAME },
+  { "TRK", ID3V2_KIND_TRCK, ID3V2_TEXT_FRAME },
+  { "TSI", ID3V2_KIND_TSIZ, ID3V2_TEXT_FRAME },
+  { "TSS", ID3V2_KIND_TSSE, ID3V2_TEXT_FRAME },
+  { "TT1", ID3V2_KIND_TIT1, ID3V2_TEXT_FRAME },
+  { "TT2", ID3V2_KIND_TIT2, ID3V2_TEXT_FRAME },
+  { "TT3", ID3V2_KIND_TIT3, ID3V2_TEXT_FRAME },
+  { "TXT", ID3V2_KIND_TEXT, ID3V2_TEXT_FRAME },
+  { "TXX", ID3V2_KIND_TXXX, ID3V2_TEXT_FRAME },
+  { "TYE", ID3V2_KIND_TYER, ID3V2_TEXT_FRAME },
+  { "UFI", ID3V2_KIND_UFID, ID3V2_INVALID_FRAME },
+  { "ULT", ID3V2_KIND_USLT, ID3V2_INVALID_FRAME },
+  { "WAF", ID3V2_KIND_WOAF, ID3V2_URL_FRAME },
+  { "WAR", ID3V2_KIND_WOAR, ID3V2_URL_FRAME },
+  { "WAS", ID3V2_KIND_WOAS, ID3V2_URL_FRAME },
+  { "WCM", ID3V2_KIND_WCOM, ID3V2_URL_FRAME },
+  { "WCP", ID3V2_KIND_WCOP, ID3V2_URL_FRAME },
+  { "WPB", ID3V2_KIND_WPUB, ID3V2_URL_FRAME },
+  { "WXX", ID3V2_KIND_WXXX, ID3V2_URL_FRAME },
+  { "TCP", ID3V2_KIND_TCMP, ID3V2_TEXT_FRAME },
+  { "TS2", ID3V2_KIND_TSO2, ID3V2_TEXT_FRAME },
+  { "TSA", ID3V2_KIND_TSOA, ID3V2_TEXT_FRAME },
+  { "TSC", ID3V2_KIND_TSOC, ID3V2_TEXT_FRAME },
+  { "TSP", ID3V2_KIND_TSOP, ID3V2_TEXT_FRAME },
+  { "TST", ID3V2_KIND_TSOT, ID3V2_TEXT_FRAME },
+  { "PCS", ID3V2_KIND_PCST, ID3V2_INVALID_FRAME },
+  { "MVN", ID3V2_KIND_MVNM, ID3V2_INVALID_FRAME },
+  { "MVI", ID3V2_KIND_MVIN, ID3V2_INVALID_FRAME },
+  { "GP1", ID3V2_KIND_GRP1, ID3V2_INVALID_FRAME }
+};
+
+// the top 6 bits of the hashed ID pick one of these, which then moves the ID to a free slot
+static const unsigned char frame_kind_displacements[64] = {
+    2,   0,   0,   3,   1,   2,   0,   9,   3,   3,   8,   9,   0,   3,   0,   5,
+    4,   1,   5,   3,   8,   9,   8,   0,   1,   4,   0,   0,   0,   4,   6,   3,
+    0,   0,   2,   0,  34,   0,   0,  10,   0,   3,   1,   4,   0,  12,   1,   0,
+    1,  12,   5,   0,   0,   0,   0,  11,  20,   9,  25,   3,   8,   4,   3,   0
+};
+
+// position in frame_kinds plus one, 0 for an empty slot
+static const unsigned char frame_kind_slots[256] = {
+    0, 145,  80,  54, 110,  22,  32, 126,   0,  41, 123,   0, 177, 162, 152,  98,
+   85,   0,   0,   0,   7,  10,  45, 141,   0,  60,   0,   0,  71,   0,   0,   0,
+   73,  53,  47, 166, 127,  70,   0, 104,  43,  13, 116,   0,   0, 151,   0,  15,
+  100, 172, 155, 164,  20,  90,  69,  82, 170, 103,  52,   3, 167,   0, 107,  51,
+   63,   0, 135,  84,   0,   0, 149, 144,   0,  17,  61, 179,  44, 138, 168, 117,
+  139, 115, 142,   0,   0, 176,  23,   0,  50,  83,  37,  21,   0,   0,   0,   0,
+    0,   0,   0,  99, 132,   0, 160,   0,  25,   0,  97, 119, 150,   5,  68, 118,
+   14, 106,  36,   6,   0, 134,  49, 111, 102, 105,   0,  38,  24,   8, 137, 147,
+  108,  16,   0, 101,   0,  46,   0,  78,   0, 128,  48, 169, 178,  35,  79, 159,
+    0,  29, 148,  12,   2,   0,  75,  59,   0,   0,   0, 157,   0, 175,  19,  92,
+   67,   0,   0,  28,  34, 173,  31,   1,   0, 129,   0, 136,  65,  89, 171,  81,
+    0,   0, 158,   0, 146,  55,   0,   4,   0, 143,  94,  88, 133,   0,   0,  95,
+    0,   0,   0, 163,  86,  72, 153, 131,  11,  40, 113,  91, 174,  30,  33, 109,
+   74,  18,   0,   0,  96,  77,  42,   0, 114,   0, 140,  27,   0,  62, 124, 112,
+   93, 121,  57,   0, 165, 130,  76,   9, 120, 122, 154,   0,  26,  66, 156,   0,
+   87, 125,   0,   0,   0,   0,  64,   0,  56,  39, 161,  58,   0,   0,   0,   0
+};
+
+// the ID as one big endian number, v2.2 IDs end with a zero byte
+static uint32_t _get_key_of_frame_id(const char *id, int version)
+{
+  const unsigned char *bytes = (const unsigned char*)id;
+
+  return (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 |
+         (version == ID3V2_2 ? 0 : bytes[3]);
+}
+
+static const frame_kind_entry *_get_frame_kind_entry(const char *id, int version)
+{
+  uint32_t hash = _get_key_of_frame_id(id, version) * FRAME_KIND_MULTIPLIER;
+  int slot = frame_kind_slots[((hash >> 16) & 0xFF) ^ frame_kind_displacements[hash >> 26]];
+
+  if(slot == 0 || memcmp(frame_kinds[slot - 1].id, id, ID3V2_DECIDE_FRAME(version, ID3V2_FRAME_ID2, ID3V2_FRAME_ID)) != 0 ||
+     (version == ID3V2_2) != (frame_kinds[slot - 1].id[ID3V2_FRAME_ID2] == '\0'))
+    return NULL;
+
+  return &frame_kinds[slot - 1];
+}
+
+// two letters followed by a letter or digit for v2.2, three letters followed by a letter or digit otherwise
+int _is_valid_frame_id(const char *id, int version)
+{
+  const unsigned char *bytes = (const unsigned char*)id;
+
+  if(version == ID3V2_2)
+    return (frame_id_characters[bytes[0]] & frame_id_characters[bytes[1]] & FRAME_ID_LETTER) &&
+           frame_id_characters[bytes[2]] != 0;
+
+  return (frame_id_characters[bytes[0]] & frame_id_characters[bytes[1]] & frame_id_characters[bytes[2]] & FRAME_ID_LETTER) &&
+         frame_id_characters[bytes[3]] != 0;
+}
+
+// returns one of the ID3V2_KIND_* constants, ID3V2_UNKNOWN_KIND for IDs no version defines
+int _get_frame_kind_from_id(const char *id, int version)
+{
+  const frame_kind_entry *entry = _get_frame_kind_entry(id, version);
+
+  return entry != NULL ? entry->kind : ID3V2_UNKNOWN_KIND;
+}
+
+// returns one of the ID3V2_*_FRAME types
+int _get_frame_type_from_id(const char *id, int version)
+{
+  const frame_kind_entry *entry = _get_frame_kind_entry(id, version);
+
+  if(entry != NULL)
+    return entry->type;
+
+  // frames we don't know are still text or links if their ID tells so
+  switch(id[0])
+  {
+    case 'T':
+      return ID3V2_TEXT_FRAME;
+    case 'W':
+      return ID3V2_URL_FRAME;
+    case 'X':
+    case 'Y':
+    case 'Z':
+      return ID3V2_EXPERIMENTAL_FRAME;
+    default:
+      return ID3V2_INVALID_FRAME;
+  }
+}
+
+int id3v2_get_frame_kind(id3v2_frame *frame)
+{
+  if(frame == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return ID3V2_UNKNOWN_KIND;
+  }
+
+  E_SUCCESS;
+
+  return _get_frame_kind_from_id(frame->id, frame->version);
+}
@@ -0,0 +1,498 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+// a frame of a tag along with what tells it apart from the others
+typedef struct
+{
+  char id[ID3V2_FRAME_ID];
+  char *key;
+  int key_size;
+  int occurrence;
+  int position; // of the frame in the tag
+  id3v2_frame *frame;
+} patch_entry;
+
+// compares ID and key, frames the standard allows only once per tag compare equal then
+static int _compare_keys_of_entries(const patch_entry *first, const patch_entry *second)
+{
+  int result = memcmp(first->id, second->id, ID3V2_FRAME_ID);
+
+  if(result != 0)
+    return result;
+
+  if(first->key_size != second->key_size)
+    return first->key_size < second->key_size ? -1 : 1;
+
+  return first->key_size > 0 ? memcmp(first->key, second->key, first->key_size) : 0;
+}
+
+static int _compare_positions_of_entries(const void *a, const void *b)
+{
+  const patch_entry *first = (const patch_entry*)a;
+  const patch_entry *second = (const patch_entry*)b;
+  int result = _compare_keys_of_entries(first, second);
+
+  return result != 0 ? result : first->position - second->position;
+}
+
+static int _compare_occurrences_of_entries(const void *a, const void *b)
+{
+  const patch_entry *first = (const patch_entry*)a;
+  const patch_entry *second = (const patch_entry*)b;
+  int result = _compare_keys_of_entries(first, second);
+
+  return result != 0 ? result : first->occurrence - second->occurrence;
+}
+
+static int _compare_frame_positions(const void *a, const void *b)
+{
+  return ((const patch_entry*)a)->position - ((const patch_entry*)b)->position;
+}
+
+static void _free_patch_entries(patch_entry *entries, int count)
+{
+  int i;
+
+  for(i = 0; i < count; i++)
+    free(entries[i].key);
+
+  free(entries);
+}
+
+// returns the frames of the tag sorted by ID, key and occurrence, NULL if there's no memory for them
+static patch_entry *_get_patch_entries_of_tag(id3v2_tag *tag, int *count)
+{
+  patch_entry *entries;
+  id3v2_frame *frame;
+  int i;
+
+  for(*count = 0, frame = tag->frame; frame != NULL; frame = frame->next)
+    (*count)++;
+
+  entries = (patch_entry*)_allocate_zeroed(*count + 1, sizeof(patch_entry));
+
+  if(entries == NULL)
+    return NULL;
+
+  for(i = 0, frame = tag->frame; frame != NULL; i++, frame = frame->next)
+  {
+    memcpy(entries[i].id, frame->id, ID3V2_FRAME_ID);
+    entries[i].position = i;
+    entries[i].frame = frame;
+
+    if(!_get_unique_key_of_frame(frame, &entries[i].key, &entries[i].key_size))
+    {
+      _free_patch_entries(entries, i);
+      return NULL;
+    }
+  }
+
+  qsort(entries, *count, sizeof(patch_entry), _compare_positions_of_entries);
+
+  for(i = 1; i < *count; i++)
+  {
+    if(_compare_keys_of_entries(&entries[i - 1], &entries[i]) == 0)
+      entries[i].occurrence = entries[i - 1].occurrence + 1;
+  }
+
+  return entries;
+}
+
+// the data of the frame along with the picture of its cached image
+static int _get_size_of_contents(id3v2_frame *frame, char **picture, int *picture_size)
+{
+  *picture = NULL;
+  *picture_size = 0;
+
+  if(frame->image != NULL)
+    _get_picture_from_cached_image(frame->image, picture, picture_size);
+
+  return frame->size + *picture_size;
+}
+
+static void _copy_contents_of_frame(id3v2_frame *frame, char *buffer)
+{
+  char *picture;
+  int picture_size;
+
+  _get_size_of_contents(frame, &picture, &picture_size);
+
+  if(frame->size > 0)
+    memcpy(buffer, frame->data, frame->size);
+  if(picture_size > 0)
+    memcpy(buffer + frame->size, picture, picture_size);
+}
+
+// returns 1 if both frames hold the same flags and data, -1 if there's no memory to compare them
+static int _have_same_contents(id3v2_frame *first, id3v2_frame *second)
+{
+  char *first_picture;
+  char *second_picture;
+  char *first_buffer;
+  char *second_buffer;
+  int first_picture_size;
+  int second_picture_size;
+  int size = _get_size_of_contents(first, &first_picture, &first_picture_size);
+  int result;
+
+  if(memcmp(first->flags, second->flags, ID3V2_FRAME_FLAGS) != 0 ||
+     size != _get_size_of_contents(second, &second_picture, &second_picture_size))
+    return 0;
+
+  // frames without pictures, or sharing the same one, are compared right where they are
+  if(first->image == second->image)
+    return first->size == 0 || memcmp(first->data, second->data, first->size) == 0;
+
+  first_buffer = (char*)_allocate(size + 1);
+  second_buffer = (char*)_allocate(size + 1);
+
+  if(first_buffer == NULL || second_buffer == NULL)
+  {
+    free(first_buffer);
+    free(second_buffer);
+    return -1;
+  }
+
+  _copy_contents_of_frame(first, first_buffer);
+  _copy_contents_of_frame(second, second_buffer);
+  result = memcmp(first_buffer, second_buffer, size) == 0;
+  free(first_buffer);
+  free(second_buffer);
+
+  return result;
+}
+
+// describes the change to the frame of the entry, frame is where the new data comes from, NULL for removals
+static int _add_patch_operation(id3v2_patch *patch, int type, patch_entry *entry, id3v2_frame *frame)
+{
+  id3v2_patch_operation *operation = &patch->operations[patch->count];
+  char *picture;
+  int picture_size;
+
+  memset(operation, 0, sizeof(id3v2_patch_operation));
+  operation->type = type;
+  memcpy(operation->id, entry->id, ID3V2_FRAME_ID);
+  operation->occurrence = entry->occurrence;
+  operation->key_size = entry->key_size;
+  operation->key = (char*)_allocate(entry->key_size + 1);
+
+  if(operation->key == NULL)
+    return 0;
+
+  if(entry->key_size > 0)
+    memcpy(operation->key, entry->key, entry->key_size);
+
+  if(frame != NULL)
+  {
+    memcpy(operation->flags, frame->flags, ID3V2_FRAME_FLAGS);
+    operation->size = _get_size_of_contents(frame, &picture, &picture_size);
+    operation->data = (char*)_allocate(operation->size + 1);
+
+    if(operation->data == NULL)
+    {
+      free(operation->key);
+      return 0;
+    }
+
+    _copy_contents_of_frame(frame, operation->data);
+  }
+
+  patch->count++;
+
+  return 1;
+}
+
+// matches the entries of both tags, which are sorted the same way, and marks each with what happens to it:
+// old entries without a match get removed, new ones get added and matches with different contents modified
+static int _match_patch_entries(patch_entry *old_entries, int old_count, patch_entry *new_entries, int new_count, char *old_changes, char *new_changes)
+{
+  int i = 0;
+  int j = 0;
+  int result;
+
+  while(i < old_count || j < new_count)
+  {
+    result = i >= old_count ? 1 : j >= new_count ? -1 : _compare_occurrences_of_entries(&old_entries[i], &new_entries[j]);
+
+    if(result < 0)
+      old_changes[old_entries[i++].position] = ID3V2_PATCH_REMOVE;
+    else if(result > 0)
+      new_changes[new_entries[j++].position] = ID3V2_PATCH_ADD;
+    else
+    {
+      result = _have_same_contents(old_entries[i].frame, new_entries[j].frame);
+
+      if(result < 0)
+        return 0;
+
+      new_changes[new_entries[j].position] = result ? 0 : ID3V2_PATCH_MODIFY;
+      i++;
+      j++;
+    }
+  }
+
+  return 1;
+}
+
+void id3v2_free_patch(id3v2_patch *patch)
+{
+  int i;
+
+  if(patch == NULL)
+    return;
+
+  for(i = 0; i < patch->count; i++)
+  {
+    free(patch->operations[i].key);
+    free(patch->operations[i].data);
+  }
+
+  free(patch->operations);
+  free(patch);
+}
+
+// returns what turns the frames of old_tag into the ones of new_tag, the headers and the padding are left out
+// frames matched by ID, key and occurrence whose data and flags are the same don't show up in it
+id3v2_patch *id3v2_diff_tags(id3v2_tag *old_tag, id3v2_tag *new_tag)
+{
+  patch_entry *old_entries = NULL;
+  patch_entry *new_entries = NULL;
+  char *old_changes = NULL;
+  char *new_changes = NULL;
+  id3v2_patch *patch = NULL;
+  int old_count = 0;
+  int new_count = 0;
+  int succeeded = 0;
+  int i;
+
+  if(old_tag == NULL || new_tag == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  if(id3v2_get_tag_version(old_tag) != id3v2_get_tag_version(new_tag))
+  {
+    E_FAIL(ID3V2_ERROR_INCOMPATIBLE_TAG);
+    return NULL;
+  }
+
+  old_entries = _get_patch_entries_of_tag(old_tag, &old_count);
+  new_entries = _get_patch_entries_of_tag(new_tag, &new_count);
+  patch = (id3v2_patch*)_allocate_zeroed(1, sizeof(id3v2_patch));
+
+  if(old_entries == NULL || new_entries == NULL || patch == NULL)
+    goto done;
+
+  old_changes = (char*)_allocate_zeroed(old_count + 1, sizeof(char));
+  new_changes = (char*)_allocate_zeroed(new_count + 1, sizeof(char));
+  patch->version = id3v2_get_tag_version(old_tag);
+  patch->operations = (id3v2_patch_operation*)_allocate((old_count + new_count + 1) * sizeof(id3v2_patch_operation));
+
+  if(old_changes == NULL || new_changes == NULL || patch->operations == NULL ||
+     !_match_patch_entries(old_entries, old_count, new_entries, new_count, old_changes, new_changes))
+    goto done;
+
+  qsort(old_entries, old_count, sizeof(patch_entry), _compare_frame_positions);
+  qsort(new_entries, new_count, sizeof(patch_entry), _compare_frame_positions);
+
+  for(i = 0; i < old_count; i++)
+  {
+    if(old_changes[i] == ID3V2_PATCH_REMOVE && !_add_patch_operation(patch, ID3V2_PATCH_REMOVE, &old_entries[i], NULL))
+      goto done;
+  }
+
+  for(i = 0; i < new_count; i++)
+  {
+    if(new_changes[i] == ID3V2_PATCH_MODIFY && !_add_patch_operation(patch, ID3V2_PATCH_MODIFY, &new_entries[i], new_entries[i].frame))
+      goto done;
+  }
+
+  for(i = 0; i < new_count; i++)
+  {
+    if(new_changes[i] == ID3V2_PATCH_ADD && !_add_patch_operation(patch, ID3V2_PATCH_ADD, &new_entries[i], new_entries[i].frame))
+      goto done;
+  }
+
+  succeeded = 1;
+
+done:
+  if(old_entries != NULL)
+    _free_patch_entries(old_entries, old_count);
+  if(new_entries != NULL)
+    _free_patch_entries(new_entries, new_count);
+  free(old_changes);
+  free(new_changes);
+
+  if(!succeeded)
+  {
+    id3v2_free_patch(patch);
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  E_SUCCESS;
+
+  return patch;
+}
+
+// frees what got allocated for a patch which can't be applied after all, the new frames aren't in the tag yet
+static void _free_patch_allocations(id3v2_patch *patch, id3v2_frame **targets, char **buffers)
+{
+  int i;
+
+  for(i = 0; i < patch->count; i++)
+  {
+    free(buffers[i]);
+    if(patch->operations[i].type == ID3V2_PATCH_ADD)
+      free(targets[i]);
+  }
+
+  free(targets);
+  free(buffers);
+}
+
+// finds the frames of all removals and modifications and allocates everything the patch needs first, so a patch
+// which doesn't fit the tag or runs out of memory leaves it untouched
+// returns 1 once the patch is applied, an empty patch changes nothing
+int id3v2_apply_patch_to_tag(id3v2_tag *tag, id3v2_patch *patch)
+{
+  id3v2_patch_operation *operation;
+  patch_entry *entries;
+  patch_entry *entry;
+  patch_entry wanted;
+  id3v2_frame **targets;
+  id3v2_frame *frame;
+  char **buffers;
+  int count;
+  int i;
+
+  if(tag == NULL || patch == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  if(patch->version != id3v2_get_tag_version(tag))
+  {
+    E_FAIL(ID3V2_ERROR_INCOMPATIBLE_TAG);
+    return 0;
+  }
+
+  if(patch->count == 0)
+  {
+    E_SUCCESS;
+    return 1;
+  }
+
+  entries = _get_patch_entries_of_tag(tag, &count);
+  targets = (id3v2_frame**)_allocate_zeroed(patch->count, sizeof(id3v2_frame*));
+  buffers = (char**)_allocate_zeroed(patch->count, sizeof(char*));
+
+  if(entries == NULL || targets == NULL || buffers == NULL)
+  {
+    if(entries != NULL)
+      _free_patch_entries(entries, count);
+    free(targets);
+    free(buffers);
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return 0;
+  }
+
+  for(i = 0; i < patch->count; i++)
+  {
+    operation = &patch->operations[i];
+
+    if(operation->type == ID3V2_PATCH_ADD)
+      continue;
+
+    memcpy(wanted.id, operation->id, ID3V2_FRAME_ID);
+    wanted.key = operation->key;
+    wanted.key_size = operation->key_size;
+    wanted.occurrence = operation->occurrence;
+    entry = (patch_entry*)bsearch(&wanted, entries, count, sizeof(patch_entry), _compare_occurrences_of_entries);
+
+    // a frame only gets changed once
+    if(entry == NULL || entry->frame == NULL)
+    {
+      _free_patch_entries(entries, count);
+      _free_patch_allocations(patch, targets, buffers);
+      E_FAIL(ID3V2_ERROR_NOT_FOUND);
+      return 0;
+    }
+
+    targets[i] = entry->frame;
+    entry->frame = NULL;
+  }
+
+  _free_patch_entries(entries, count);
+
+  for(i = 0; i < patch->count; i++)
+  {
+    operation = &patch->operations[i];
+
+    if(operation->type == ID3V2_PATCH_REMOVE)
+      continue;
+
+    buffers[i] = (char*)_allocate(operation->size + 1);
+
+    // added frames only join the tag once nothing can fail anymore, so they don't come from id3v2_new_frame()
+    if(operation->type == ID3V2_PATCH_ADD)
+      targets[i] = (id3v2_frame*)_allocate_zeroed(1, sizeof(id3v2_frame));
+
+    if(buffers[i] == NULL || targets[i] == NULL)
+    {
+      _free_patch_allocations(patch, targets, buffers);
+      E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+      return 0;
+    }
+  }
+
+  for(i = 0; i < patch->count; i++)
+  {
+    operation = &patch->operations[i];
+    frame = targets[i];
+
+    if(operation->type == ID3V2_PATCH_REMOVE)
+    {
+      _detach_frame_from_tag(tag, frame);
+      _free_frame(frame);
+      continue;
+    }
+
+    if(operation->type == ID3V2_PATCH_ADD)
+    {
+      frame->version = patch->version;
+      frame->tag = tag;
+      id3v2_add_frame_to_tag(tag, frame);
+    }
+    else
+      _release_frame_data(frame);
+
+    if(operation->size > 0)
+      memcpy(buffers[i], operation->data, operation->size);
+    memcpy(frame->id, operation->id, ID3V2_FRAME_ID);
+    memcpy(frame->flags, operation->flags, ID3V2_FRAME_FLAGS);
+    frame->data = buffers[i];
+    frame->size = operation->size;
+    frame->parsed = 1;
+  }
+
+  free(targets);
+  free(buffers);
+
+  E_SUCCESS;
+
+  return 1;
+}
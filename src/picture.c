@@ -0,0 +1,668 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // fileno() and write()
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define write _write
+#else
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+#include "id3v2lib.h"
+
+#define PICTURE_STREAM_BUFFER 4096
+#define PICTURE_PREFIX_LIMIT 1024 // encoding, mime type, picture type and description have to fit in here
+
+// reads a byte range of a file through a fixed buffer, optionally reversing the unsynchronization
+typedef struct
+{
+  FILE *file;
+  int64_t raw_offset; // file position of the next raw byte to fetch
+  int raw_remaining; // raw bytes left in the range
+  char decode;
+  char pending_ff;
+  char buffer[PICTURE_STREAM_BUFFER];
+  int position;
+  int length;
+} picture_stream;
+
+static void _open_picture_stream(picture_stream *stream, FILE *file, int64_t offset, int size, char decode)
+{
+  stream->file = file;
+  stream->raw_offset = offset;
+  stream->raw_remaining = size;
+  stream->decode = decode;
+  stream->pending_ff = 0;
+  stream->position = 0;
+  stream->length = 0;
+}
+
+static int _fill_picture_stream(picture_stream *stream)
+{
+  int size = stream->raw_remaining < PICTURE_STREAM_BUFFER ? stream->raw_remaining : PICTURE_STREAM_BUFFER;
+  int read_size;
+
+  if(size <= 0 || _seek_in_file(stream->file, stream->raw_offset, SEEK_SET) != 0)
+    return 0;
+
+  read_size = (int)fread(stream->buffer, 1, size, stream->file);
+
+  if(read_size <= 0)
+  {
+    // the file is shorter than the tag claims
+    stream->raw_remaining = 0;
+    return 0;
+  }
+
+  stream->raw_offset += read_size;
+  stream->raw_remaining -= read_size;
+  stream->position = 0;
+  stream->length = stream->decode ? _synchronize_buffer(stream->buffer, read_size, &stream->pending_ff) : read_size;
+
+  return 1;
+}
+
+static int _read_picture_stream(picture_stream *stream, char *data, int size)
+{
+  int copied = 0;
+  int chunk;
+
+  while(copied < size)
+  {
+    if(stream->position == stream->length)
+    {
+      if(!_fill_picture_stream(stream))
+        break;
+      continue;
+    }
+
+    chunk = stream->length - stream->position;
+    if(chunk > size - copied)
+      chunk = size - copied;
+
+    memcpy(data + copied, stream->buffer + stream->position, chunk);
+    stream->position += chunk;
+    copied += chunk;
+  }
+
+  return copied;
+}
+
+static void _skip_picture_stream(picture_stream *stream, int size)
+{
+  char scratch[PICTURE_STREAM_BUFFER];
+  int chunk;
+
+  if(stream->decode)
+  {
+    // the amount of raw bytes is unknown, so we have to decode our way through
+    while(size > 0)
+    {
+      chunk = _read_picture_stream(stream, scratch, size < PICTURE_STREAM_BUFFER ? size : PICTURE_STREAM_BUFFER);
+      if(chunk == 0)
+        return;
+      size -= chunk;
+    }
+    return;
+  }
+
+  chunk = stream->length - stream->position;
+  if(chunk > size)
+    chunk = size;
+
+  stream->position += chunk;
+  size -= chunk;
+
+  if(size > stream->raw_remaining)
+    size = stream->raw_remaining;
+
+  stream->raw_offset += size;
+  stream->raw_remaining -= size;
+}
+
+// file position of the next byte a non-decoding stream hands out
+static int64_t _get_position_of_picture_stream(picture_stream *stream)
+{
+  return stream->raw_offset - (stream->length - stream->position);
+}
+
+static int _write_fully(int fd, const char *data, int size)
+{
+  int written = 0;
+  int chunk;
+
+  while(written < size)
+  {
+    chunk = (int)write(fd, data + written, size - written);
+    if(chunk <= 0)
+      return 0;
+    written += chunk;
+  }
+
+  return 1;
+}
+
+// moves up to size bytes of the stream into fd, returns the amount of bytes written or -1 on write errors
+static int _send_picture_stream(picture_stream *stream, int fd, int size)
+{
+  int chunk;
+  int written = 0;
+#ifdef __linux__
+  off_t offset;
+  ssize_t sent;
+#endif
+
+  // hand out whatever is buffered already
+  if(stream->position < stream->length)
+  {
+    chunk = stream->length - stream->position;
+    if(chunk > size)
+      chunk = size;
+    if(!_write_fully(fd, stream->buffer + stream->position, chunk))
+      return -1;
+    stream->position += chunk;
+    written += chunk;
+  }
+
+#ifdef __linux__
+  // without unsynchronization the payload is a plain file range, so let the kernel copy it
+  if(!stream->decode)
+  {
+    offset = stream->raw_offset;
+    while(written < size && stream->raw_remaining > 0)
+    {
+      chunk = size - written;
+      if(chunk > stream->raw_remaining)
+        chunk = stream->raw_remaining;
+      sent = sendfile(fd, fileno(stream->file), &offset, chunk);
+      if(sent <= 0)
+        break; // not supported for this pair of descriptors, copy it ourselves below
+      stream->raw_offset += sent;
+      stream->raw_remaining -= (int)sent;
+      written += (int)sent;
+    }
+  }
+#endif
+
+  while(written < size)
+  {
+    if(stream->position == stream->length && !_fill_picture_stream(stream))
+      break;
+
+    chunk = stream->length - stream->position;
+    if(chunk > size - written)
+      chunk = size - written;
+    if(!_write_fully(fd, stream->buffer + stream->position, chunk))
+      return -1;
+    stream->position += chunk;
+    written += chunk;
+  }
+
+  return written;
+}
+
+// returns the length of the APIC/PIC fields in front of the picture or 0 if they don't fit into prefix
+static int _get_picture_offset_from_prefix(char *prefix, int size, int version, int *picture_type)
+{
+  char encoding;
+  int offset = ID3V2_FRAME_ENCODING;
+
+  if(size < ID3V2_FRAME_ENCODING)
+    return 0;
+
+  encoding = prefix[0];
+
+  if(version == ID3V2_2)
+    offset += 3; // fixed size image format
+  else
+  {
+    while(offset < size && prefix[offset] != '\0')
+      offset++;
+    offset++;
+  }
+
+  if(offset >= size)
+    return 0;
+
+  *picture_type = (unsigned char)prefix[offset++];
+
+  if(encoding == ID3V2_UTF_16_ENCODING_WITH_BOM || encoding == ID3V2_UTF_16_ENCODING_WITHOUT_BOM)
+  {
+    while(offset + 1 < size && (prefix[offset] != '\0' || prefix[offset + 1] != '\0'))
+      offset += 2;
+    offset += 2;
+  }
+  else
+  {
+    while(offset < size && prefix[offset] != '\0')
+      offset++;
+    offset++;
+  }
+
+  if(offset > size)
+    return 0;
+
+  return offset;
+}
+
+int id3v2_extract_picture_to_fd(FILE *file, int picture_type, int fd)
+{
+  char raw_header[ID3V2_HEADER + ID3V2_EXTENDED_HEADER_SIZE];
+  char frame_header[ID3V2_FRAME];
+  char prefix[PICTURE_PREFIX_LIMIT];
+  picture_stream tag_stream;
+  picture_stream frame_stream;
+  picture_stream *stream;
+  int count;
+  int extended_header_size;
+  int flags;
+  int frame_header_size;
+  int frame_size;
+  int frame_unsynchronized;
+  int frame_type;
+  int64_t *offsets;
+  int picture_offset;
+  int prefix_size;
+  int remaining;
+  int tag_body_size;
+  int64_t tag_offset;
+  int version;
+  int written;
+
+  if(file == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    return 0;
+  }
+
+  _find_header_offsets_in_file(file, &offsets, &count);
+
+  if(count == 0)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  tag_offset = offsets[0];
+  free(offsets);
+
+  memset(raw_header, 0, sizeof(raw_header));
+  _seek_in_file(file, tag_offset, SEEK_SET);
+  if(fread(raw_header, 1, sizeof(raw_header), file) < ID3V2_HEADER)
+  {
+    E_FAIL(ID3V2_ERROR_INSUFFICIENT_DATA);
+    return 0;
+  }
+
+  version = raw_header[3];
+  flags = (unsigned char)raw_header[5];
+  tag_body_size = syncint_decode(btoi(raw_header, ID3V2_HEADER_SIZE, 6));
+
+  if(version != ID3V2_2 && version != ID3V2_3 && version != ID3V2_4)
+  {
+    E_FAIL(ID3V2_ERROR_INCOMPATIBLE_TAG);
+    return 0;
+  }
+
+  // v2.2 and v2.3 unsynchronize the whole tag, including the frame headers
+  _open_picture_stream(&tag_stream, file, tag_offset + ID3V2_HEADER, tag_body_size, version != ID3V2_4 && (flags & 0x80));
+
+  if(flags & 0x40)
+  {
+    if(version == ID3V2_4)
+      extended_header_size = syncint_decode(btoi(raw_header, ID3V2_EXTENDED_HEADER_SIZE, ID3V2_HEADER));
+    else
+      extended_header_size = btoi(raw_header, ID3V2_EXTENDED_HEADER_SIZE, ID3V2_HEADER) + ID3V2_EXTENDED_HEADER_SIZE;
+    _skip_picture_stream(&tag_stream, extended_header_size);
+  }
+
+  frame_header_size = version == ID3V2_2 ? ID3V2_FRAME_ID2 + ID3V2_FRAME_SIZE2 : ID3V2_FRAME;
+
+  while(_read_picture_stream(&tag_stream, frame_header, frame_header_size) == frame_header_size)
+  {
+    if(frame_header[0] == '\0')
+      break; // padding reached
+
+    if(version == ID3V2_2)
+      frame_size = btoi(frame_header, ID3V2_FRAME_SIZE2, ID3V2_FRAME_ID2);
+    else
+      frame_size = btoi(frame_header, ID3V2_FRAME_SIZE, ID3V2_FRAME_ID);
+
+    if(version == ID3V2_4)
+      frame_size = syncint_decode(frame_size);
+
+    if(frame_size <= 0)
+      break;
+
+    if((version == ID3V2_2 && memcmp(frame_header, "PIC", 3) != 0) ||
+       (version != ID3V2_2 && memcmp(frame_header, "APIC", 4) != 0) ||
+       (version == ID3V2_3 && (frame_header[9] & 0xC0)) || // compressed or encrypted
+       (version == ID3V2_4 && (frame_header[9] & 0x0C)))
+    {
+      _skip_picture_stream(&tag_stream, frame_size);
+      continue;
+    }
+
+    if(version == ID3V2_4)
+    {
+      // v2.4 frame sizes count the raw bytes, so every frame gets its own stream
+      frame_unsynchronized = (flags & 0x80) || (frame_header[9] & 0x02);
+      _open_picture_stream(&frame_stream, file, _get_position_of_picture_stream(&tag_stream), frame_size, frame_unsynchronized);
+      _skip_picture_stream(&tag_stream, frame_size);
+      stream = &frame_stream;
+      remaining = INT_MAX;
+      if(frame_header[9] & 0x01)
+        _skip_picture_stream(stream, 4); // data length indicator
+    }
+    else
+    {
+      stream = &tag_stream;
+      remaining = frame_size;
+    }
+
+    prefix_size = _read_picture_stream(stream, prefix, remaining < PICTURE_PREFIX_LIMIT ? remaining : PICTURE_PREFIX_LIMIT);
+    if(remaining != INT_MAX)
+      remaining -= prefix_size;
+
+    picture_offset = _get_picture_offset_from_prefix(prefix, prefix_size, version, &frame_type);
+
+    if(picture_offset == 0 || (picture_type != ID3V2_ANY_PICTURE_TYPE && picture_type != frame_type))
+    {
+      if(stream == &tag_stream)
+        _skip_picture_stream(&tag_stream, remaining);
+      continue;
+    }
+
+    if(!_write_fully(fd, prefix + picture_offset, prefix_size - picture_offset))
+    {
+      E_FAIL(ID3V2_ERROR_IO);
+      return 0;
+    }
+
+    written = _send_picture_stream(stream, fd, remaining);
+
+    if(written < 0)
+    {
+      E_FAIL(ID3V2_ERROR_IO);
+      return 0;
+    }
+
+    E_SUCCESS;
+
+    return prefix_size - picture_offset + written;
+  }
+
+  E_FAIL(ID3V2_ERROR_NOT_FOUND);
+
+  return 0;
+}
+
+static int _read_uint16_le_from_buffer(const unsigned char *data)
+{
+  return data[0] | (data[1] << 8);
+}
+
+static int _read_uint16_be_from_buffer(const unsigned char *data)
+{
+  return (data[0] << 8) | data[1];
+}
+
+static unsigned int _read_uint32_le_from_buffer(const unsigned char *data)
+{
+  return (unsigned int)data[0] | ((unsigned int)data[1] << 8) | ((unsigned int)data[2] << 16) | ((unsigned int)data[3] << 24);
+}
+
+int _get_picture_format_from_buffer(const char *buffer, int size)
+{
+  const unsigned char *data = (const unsigned char*)buffer;
+
+  if(data == NULL)
+    return ID3V2_PICTURE_FORMAT_UNKNOWN;
+
+  if(size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF)
+    return ID3V2_PICTURE_FORMAT_JPEG;
+  if(size >= 8 && memcmp(data, "\x89PNG\r\n\x1A\n", 8) == 0)
+    return ID3V2_PICTURE_FORMAT_PNG;
+  if(size >= 6 && (memcmp(data, "GIF87a", 6) == 0 || memcmp(data, "GIF89a", 6) == 0))
+    return ID3V2_PICTURE_FORMAT_GIF;
+  if(size >= 2 && memcmp(data, "BM", 2) == 0)
+    return ID3V2_PICTURE_FORMAT_BMP;
+  if(size >= 12 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WEBP", 4) == 0)
+    return ID3V2_PICTURE_FORMAT_WEBP;
+
+  return ID3V2_PICTURE_FORMAT_UNKNOWN;
+}
+
+static void _probe_jpeg_picture(const unsigned char *data, int size, id3v2_picture_info *info)
+{
+  int marker;
+  int offset = 2; // skip SOI
+  int segment_size;
+
+  // walk the marker segments until we hit a start of frame, without touching the entropy coded data
+  while(offset + 4 <= size)
+  {
+    if(data[offset] != 0xFF)
+      return;
+
+    marker = data[offset + 1];
+
+    if(marker == 0xFF)
+    {
+      offset++; // fill byte
+      continue;
+    }
+
+    if(marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+    {
+      offset += 2; // markers without a length
+      continue;
+    }
+
+    if(marker == 0xD9 || marker == 0xDA)
+      return; // end of image or start of scan before any frame header
+
+    segment_size = _read_uint16_be_from_buffer(data + offset + 2);
+
+    if(marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+    {
+      if(offset + 10 > size)
+        return;
+      info->height = _read_uint16_be_from_buffer(data + offset + 5);
+      info->width = _read_uint16_be_from_buffer(data + offset + 7);
+      info->depth = data[offset + 4] * data[offset + 9];
+      return;
+    }
+
+    offset += 2 + segment_size;
+  }
+}
+
+static void _probe_png_picture(const unsigned char *data, int size, id3v2_picture_info *info)
+{
+  int channels;
+
+  // IHDR is always the first chunk
+  if(size < 26 || memcmp(data + 12, "IHDR", 4) != 0)
+    return;
+
+  info->width = (int)btoi((char*)data, 4, 16);
+  info->height = (int)btoi((char*)data, 4, 20);
+
+  switch(data[25])
+  {
+    case 2:
+      channels = 3; // truecolour
+      break;
+    case 4:
+      channels = 2; // greyscale with alpha
+      break;
+    case 6:
+      channels = 4; // truecolour with alpha
+      break;
+    default:
+      channels = 1; // greyscale or palette
+  }
+
+  info->depth = data[24] * channels;
+}
+
+static void _probe_gif_picture(const unsigned char *data, int size, id3v2_picture_info *info)
+{
+  if(size < 11)
+    return;
+
+  info->width = _read_uint16_le_from_buffer(data + 6);
+  info->height = _read_uint16_le_from_buffer(data + 8);
+
+  if(data[10] & 0x80)
+    info->depth = (data[10] & 0x07) + 1; // size of the global colour table
+  else
+    info->depth = ((data[10] >> 4) & 0x07) + 1; // colour resolution
+}
+
+static void _probe_bmp_picture(const unsigned char *data, int size, id3v2_picture_info *info)
+{
+  int height;
+
+  if(size < 26)
+    return;
+
+  if(_read_uint32_le_from_buffer(data + 14) == 12)
+  {
+    // OS/2 core header with 16 bit dimensions
+    info->width = _read_uint16_le_from_buffer(data + 18);
+    info->height = _read_uint16_le_from_buffer(data + 20);
+    info->depth = _read_uint16_le_from_buffer(data + 24);
+    return;
+  }
+
+  if(size < 30)
+    return;
+
+  info->width = (int)_read_uint32_le_from_buffer(data + 18);
+  height = (int)_read_uint32_le_from_buffer(data + 22);
+  info->height = height < 0 ? -height : height; // negative heights mark top-down bitmaps
+  info->depth = _read_uint16_le_from_buffer(data + 28);
+}
+
+static void _probe_webp_picture(const unsigned char *data, int size, id3v2_picture_info *info)
+{
+  unsigned int bits;
+
+  if(size < 30)
+    return;
+
+  if(memcmp(data + 12, "VP8 ", 4) == 0)
+  {
+    // lossy, the key frame header follows the 3 byte frame tag and start code
+    if(data[23] != 0x9D || data[24] != 0x01 || data[25] != 0x2A)
+      return;
+    info->width = _read_uint16_le_from_buffer(data + 26) & 0x3FFF;
+    info->height = _read_uint16_le_from_buffer(data + 28) & 0x3FFF;
+    info->depth = 24;
+  }
+  else if(memcmp(data + 12, "VP8L", 4) == 0)
+  {
+    // lossless, 14 bit dimensions packed behind the signature byte
+    if(data[20] != 0x2F)
+      return;
+    bits = _read_uint32_le_from_buffer(data + 21);
+    info->width = (bits & 0x3FFF) + 1;
+    info->height = ((bits >> 14) & 0x3FFF) + 1;
+    info->depth = ((bits >> 28) & 0x01) ? 32 : 24;
+  }
+  else if(memcmp(data + 12, "VP8X", 4) == 0)
+  {
+    // extended format with a 24 bit canvas size
+    info->width = (data[24] | (data[25] << 8) | (data[26] << 16)) + 1;
+    info->height = (data[27] | (data[28] << 8) | (data[29] << 16)) + 1;
+    info->depth = (data[20] & 0x10) ? 32 : 24;
+  }
+}
+
+void id3v2_probe_picture_in_buffer(const char *buffer, int size, id3v2_picture_info *info)
+{
+  const unsigned char *data = (const unsigned char*)buffer;
+
+  if(info == NULL || buffer == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return;
+  }
+
+  info->format = _get_picture_format_from_buffer(buffer, size);
+  info->width = 0;
+  info->height = 0;
+  info->depth = 0;
+
+  switch(info->format)
+  {
+    case ID3V2_PICTURE_FORMAT_JPEG:
+      _probe_jpeg_picture(data, size, info);
+      break;
+    case ID3V2_PICTURE_FORMAT_PNG:
+      _probe_png_picture(data, size, info);
+      break;
+    case ID3V2_PICTURE_FORMAT_GIF:
+      _probe_gif_picture(data, size, info);
+      break;
+    case ID3V2_PICTURE_FORMAT_BMP:
+      _probe_bmp_picture(data, size, info);
+      break;
+    case ID3V2_PICTURE_FORMAT_WEBP:
+      _probe_webp_picture(data, size, info);
+      break;
+    default:
+      E_FAIL(ID3V2_ERROR_UNKNOWN_MIME_TYPE);
+      return;
+  }
+
+  if(info->width == 0 || info->height == 0)
+  {
+    // the header is truncated or broken
+    E_FAIL(ID3V2_ERROR_INSUFFICIENT_DATA);
+    return;
+  }
+
+  E_SUCCESS;
+}
+
+void id3v2_probe_picture_in_frame(id3v2_frame *frame, id3v2_picture_info *info)
+{
+  char *mime_type;
+  char *picture;
+  int size;
+
+  if(frame == NULL || info == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return;
+  }
+
+  id3v2_get_picture_from_frame(frame, &picture, &size, &mime_type);
+
+  if(E_GET != ID3V2_OK)
+    return;
+
+  id3v2_probe_picture_in_buffer(picture, size, info);
+}
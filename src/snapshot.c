@@ -0,0 +1,528 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "id3v2lib.h"
+
+// A snapshot holds parsed tags in a flat layout, every reference in it is an offset from its start:
+//   header       magic "ID3SNAP\0", format version and tag count as 32 bit integers, the snapshot size as 64 bit integer
+//   tag table    per tag the major and minor version, the flags, a zero byte, the frame count, the tag size and the
+//                extended header size as 32 bit integers and the offset of its first frame table entry as 64 bit integer
+//   frame table  per frame its id, both flag bytes, the version, the parsed flag, the size, 4 zero bytes and the offset
+//                of its data as 64 bit integer
+//   bodies       the frame data, pictures of cached images included, each starting at a multiple of 8 bytes
+// All integers are little endian, so a mapped snapshot is read without any parsing.
+#define SNAPSHOT_MAGIC "ID3SNAP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER 24
+#define SNAPSHOT_TAG 24
+#define SNAPSHOT_FRAME 24
+#define SNAPSHOT_ALIGNMENT 8
+
+struct id3v2_snapshot
+{
+  const char *data;
+  int64_t size;
+  int tag_count;
+  char mapped; // data has to be unmapped
+  char allocated; // data has to be freed
+};
+
+typedef int (*snapshot_sink)(void *context, const char *data, size_t size);
+
+static int64_t _get_padded_size(int64_t size)
+{
+  return (size + SNAPSHOT_ALIGNMENT - 1) & ~(int64_t)(SNAPSHOT_ALIGNMENT - 1);
+}
+
+static int _get_size_of_frame_in_snapshot(id3v2_frame *frame, char **picture)
+{
+  int picture_size = 0;
+
+  *picture = NULL;
+
+  if(frame->image != NULL)
+    _get_picture_from_cached_image(frame->image, picture, &picture_size);
+
+  return frame->size + picture_size;
+}
+
+// writes the snapshot in a single pass, the offsets are known up front
+static int _write_snapshot(id3v2_tag **tags, int count, snapshot_sink sink, void *context)
+{
+  int64_t body_offset;
+  int64_t body_size = 0;
+  char entry[SNAPSHOT_HEADER];
+  id3v2_frame *frame;
+  int frame_count;
+  int64_t frame_offset;
+  int64_t frame_total = 0;
+  int i;
+  static const char padding[SNAPSHOT_ALIGNMENT] = { 0 };
+  char *picture;
+  int size;
+
+  for(i = 0; i < count; i++)
+  {
+    if(tags[i] == NULL || tags[i]->header == NULL)
+    {
+      E_FAIL(ID3V2_ERROR_NOT_FOUND);
+      return 0;
+    }
+
+    for(frame = tags[i]->frame; frame != NULL; frame = frame->next)
+    {
+      frame_total++;
+      body_size += _get_padded_size(_get_size_of_frame_in_snapshot(frame, &picture));
+    }
+  }
+
+  frame_offset = SNAPSHOT_HEADER + (int64_t)count * SNAPSHOT_TAG;
+  body_offset = frame_offset + frame_total * SNAPSHOT_FRAME;
+
+  memset(entry, 0, sizeof(entry));
+  memcpy(entry, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  _write_little_endian_to_buffer(entry + 8, SNAPSHOT_VERSION, 4);
+  _write_little_endian_to_buffer(entry + 12, (uint64_t)count, 4);
+  _write_little_endian_to_buffer(entry + 16, (uint64_t)(body_offset + body_size), 8);
+
+  if(!sink(context, entry, SNAPSHOT_HEADER))
+    return 0;
+
+  for(i = 0; i < count; i++)
+  {
+    frame_count = 0;
+    for(frame = tags[i]->frame; frame != NULL; frame = frame->next)
+      frame_count++;
+
+    memset(entry, 0, sizeof(entry));
+    entry[0] = tags[i]->header->major_version;
+    entry[1] = tags[i]->header->minor_version;
+    entry[2] = tags[i]->header->flags;
+    _write_little_endian_to_buffer(entry + 4, (uint64_t)frame_count, 4);
+    _write_little_endian_to_buffer(entry + 8, (uint64_t)(uint32_t)tags[i]->header->tag_size, 4);
+    _write_little_endian_to_buffer(entry + 12, (uint64_t)(uint32_t)tags[i]->header->extended_header_size, 4);
+    _write_little_endian_to_buffer(entry + 16, (uint64_t)frame_offset, 8);
+
+    if(!sink(context, entry, SNAPSHOT_TAG))
+      return 0;
+
+    frame_offset += (int64_t)frame_count * SNAPSHOT_FRAME;
+  }
+
+  for(i = 0; i < count; i++)
+  {
+    for(frame = tags[i]->frame; frame != NULL; frame = frame->next)
+    {
+      size = _get_size_of_frame_in_snapshot(frame, &picture);
+
+      memset(entry, 0, sizeof(entry));
+      memcpy(entry, frame->id, ID3V2_FRAME_ID);
+      memcpy(entry + ID3V2_FRAME_ID, frame->flags, ID3V2_FRAME_FLAGS);
+      entry[6] = (char)frame->version;
+      entry[7] = frame->parsed;
+      _write_little_endian_to_buffer(entry + 8, (uint64_t)size, 4);
+      _write_little_endian_to_buffer(entry + 16, (uint64_t)body_offset, 8);
+
+      if(!sink(context, entry, SNAPSHOT_FRAME))
+        return 0;
+
+      body_offset += _get_padded_size(size);
+    }
+  }
+
+  for(i = 0; i < count; i++)
+  {
+    for(frame = tags[i]->frame; frame != NULL; frame = frame->next)
+    {
+      size = _get_size_of_frame_in_snapshot(frame, &picture);
+
+      if(!sink(context, frame->data, frame->size) ||
+         (picture != NULL && !sink(context, picture, size - frame->size)) ||
+         !sink(context, padding, (size_t)(_get_padded_size(size) - size)))
+        return 0;
+    }
+  }
+
+  return 1;
+}
+
+static int _write_snapshot_to_file(void *context, const char *data, size_t size)
+{
+  if(size > 0 && fwrite(data, 1, size, (FILE*)context) != size)
+  {
+    E_FAIL(ID3V2_ERROR_IO);
+    return 0;
+  }
+
+  return 1;
+}
+
+typedef struct
+{
+  char *buffer;
+  size_t size;
+  size_t capacity;
+} snapshot_buffer;
+
+static int _write_snapshot_to_buffer(void *context, const char *data, size_t size)
+{
+  snapshot_buffer *buffer = (snapshot_buffer*)context;
+  char *resized;
+  size_t capacity;
+
+  if(buffer->size + size > buffer->capacity)
+  {
+    capacity = buffer->capacity > 0 ? buffer->capacity : 4096;
+    while(capacity < buffer->size + size)
+      capacity *= 2;
+
+    resized = (char*)_reallocate(buffer->buffer, capacity);
+
+    if(resized == NULL)
+    {
+      E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+      return 0;
+    }
+
+    buffer->buffer = resized;
+    buffer->capacity = capacity;
+  }
+
+  if(size > 0)
+    memcpy(buffer->buffer + buffer->size, data, size);
+  buffer->size += size;
+
+  return 1;
+}
+
+// writes the tags as snapshot at the current position of the file, returns 0 on failure
+int id3v2_write_snapshot_to_file(id3v2_tag **tags, int count, FILE *file)
+{
+  if((tags == NULL && count > 0) || count < 0 || file == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  if(!_write_snapshot(tags, count, _write_snapshot_to_file, file))
+    return 0;
+
+  E_SUCCESS;
+
+  return 1;
+}
+
+// returns the tags as snapshot in a buffer the caller has to free or NULL
+char *id3v2_write_snapshot_to_buffer(id3v2_tag **tags, int count, size_t *size)
+{
+  snapshot_buffer buffer = { NULL, 0, 0 };
+
+  *size = 0;
+
+  if((tags == NULL && count > 0) || count < 0)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  if(!_write_snapshot(tags, count, _write_snapshot_to_buffer, &buffer))
+  {
+    free(buffer.buffer);
+    return NULL;
+  }
+
+  *size = buffer.size;
+
+  E_SUCCESS;
+
+  return buffer.buffer;
+}
+
+// the buffer has to outlive the snapshot, nothing gets copied
+id3v2_snapshot *id3v2_map_snapshot_from_buffer(const char *buffer, size_t length)
+{
+  id3v2_snapshot *snapshot;
+  int tag_count;
+
+  if(buffer == NULL || length < SNAPSHOT_HEADER || memcmp(buffer, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  tag_count = (int)_read_little_endian_from_buffer(buffer + 12, 4);
+
+  if(_read_little_endian_from_buffer(buffer + 8, 4) != SNAPSHOT_VERSION ||
+     _read_little_endian_from_buffer(buffer + 16, 8) != (uint64_t)length ||
+     tag_count < 0 || SNAPSHOT_HEADER + (int64_t)tag_count * SNAPSHOT_TAG > (int64_t)length)
+  {
+    E_FAIL(ID3V2_ERROR_UNSUPPORTED);
+    return NULL;
+  }
+
+  snapshot = (id3v2_snapshot*)_allocate_zeroed(1, sizeof(id3v2_snapshot));
+
+  if(snapshot == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  snapshot->data = buffer;
+  snapshot->size = (int64_t)length;
+  snapshot->tag_count = tag_count;
+
+  E_SUCCESS;
+
+  return snapshot;
+}
+
+// maps the snapshot file read only, only the pages of the tags looked at get read
+id3v2_snapshot *id3v2_map_snapshot_from_file(const char *path)
+{
+  char *data;
+  int fd;
+  int64_t length;
+  id3v2_snapshot *snapshot;
+
+  if(path == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    return NULL;
+  }
+
+#ifdef _WIN32
+  fd = _open(path, _O_RDONLY | _O_BINARY);
+#else
+  fd = open(path, O_RDONLY);
+#endif
+
+  if(fd < 0)
+  {
+    E_FAIL(ID3V2_ERROR_UNABLE_TO_OPEN);
+    return NULL;
+  }
+
+  length = _get_length_of_fd(fd);
+
+  if(length < SNAPSHOT_HEADER)
+  {
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+#ifdef _WIN32
+  // no mapping here, the snapshot is read at once
+  data = (char*)_allocate((size_t)length);
+  if(data != NULL && _read_from_fd(fd, 0, data, (int)length) != length)
+  {
+    free(data);
+    data = NULL;
+  }
+  _close(fd);
+#else
+  data = (char*)mmap(NULL, (size_t)length, PROT_READ, MAP_PRIVATE, fd, 0);
+  if(data == MAP_FAILED)
+    data = NULL;
+  close(fd);
+#endif
+
+  if(data == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_IO);
+    return NULL;
+  }
+
+  snapshot = id3v2_map_snapshot_from_buffer(data, (size_t)length);
+
+  if(snapshot == NULL)
+  {
+#ifdef _WIN32
+    free(data);
+#else
+    munmap(data, (size_t)length);
+#endif
+    return NULL;
+  }
+
+#ifdef _WIN32
+  snapshot->allocated = 1;
+#else
+  snapshot->mapped = 1;
+#endif
+
+  return snapshot;
+}
+
+void id3v2_unmap_snapshot(id3v2_snapshot *snapshot)
+{
+  if(snapshot == NULL)
+    return;
+
+#ifndef _WIN32
+  if(snapshot->mapped)
+    munmap((void*)snapshot->data, (size_t)snapshot->size);
+#endif
+  if(snapshot->allocated)
+    free((void*)snapshot->data);
+
+  free(snapshot);
+}
+
+int id3v2_get_tag_count_from_snapshot(id3v2_snapshot *snapshot)
+{
+  if(snapshot == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  E_SUCCESS;
+
+  return snapshot->tag_count;
+}
+
+static const char *_get_tag_entry_from_snapshot(id3v2_snapshot *snapshot, int index)
+{
+  if(snapshot == NULL || index < 0 || index >= snapshot->tag_count)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  return snapshot->data + SNAPSHOT_HEADER + (int64_t)index * SNAPSHOT_TAG;
+}
+
+int id3v2_get_frame_count_from_snapshot(id3v2_snapshot *snapshot, int tag_index)
+{
+  const char *entry = _get_tag_entry_from_snapshot(snapshot, tag_index);
+
+  if(entry == NULL)
+    return 0;
+
+  E_SUCCESS;
+
+  return (int)_read_little_endian_from_buffer(entry + 4, 4);
+}
+
+// fills in the header of a tag, returns 0 if there is no such tag
+int id3v2_get_header_from_snapshot(id3v2_snapshot *snapshot, int tag_index, id3v2_header *header)
+{
+  const char *entry = _get_tag_entry_from_snapshot(snapshot, tag_index);
+
+  if(entry == NULL || header == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  memcpy(header->tag, "ID3", ID3V2_HEADER_TAG);
+  header->major_version = entry[0];
+  header->minor_version = entry[1];
+  header->flags = entry[2];
+  header->tag_size = (int)_read_little_endian_from_buffer(entry + 8, 4);
+  header->extended_header_size = (int)_read_little_endian_from_buffer(entry + 12, 4);
+
+  E_SUCCESS;
+
+  return 1;
+}
+
+// fills in a frame whose data points into the snapshot, so it is valid as long as the snapshot is mapped
+// the frame is marked interned, it must neither be modified nor freed and doesn't belong to a tag
+// contents found by the typed getters have to be freed with id3v2_free_contents_of_frame() before the frame is filled again
+// returns 0 if there is no such frame
+int id3v2_get_frame_from_snapshot(id3v2_snapshot *snapshot, int tag_index, int frame_index, id3v2_frame *frame)
+{
+  const char *entry = _get_tag_entry_from_snapshot(snapshot, tag_index);
+  uint64_t data_offset;
+  uint64_t offset;
+  int size;
+
+  if(entry == NULL || frame == NULL || frame_index < 0 || frame_index >= (int)_read_little_endian_from_buffer(entry + 4, 4))
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return 0;
+  }
+
+  offset = _read_little_endian_from_buffer(entry + 16, 8);
+
+  // the offsets are compared with what's left of the snapshot, so broken ones can't overflow
+  if(offset < SNAPSHOT_HEADER || offset > (uint64_t)snapshot->size - SNAPSHOT_FRAME ||
+     (uint64_t)frame_index > ((uint64_t)snapshot->size - SNAPSHOT_FRAME - offset) / SNAPSHOT_FRAME)
+  {
+    E_FAIL(ID3V2_ERROR_UNSUPPORTED);
+    return 0;
+  }
+
+  entry = snapshot->data + offset + (uint64_t)frame_index * SNAPSHOT_FRAME;
+  size = (int)_read_little_endian_from_buffer(entry + 8, 4);
+  data_offset = _read_little_endian_from_buffer(entry + 16, 8);
+
+  if(size < 0 || data_offset < SNAPSHOT_HEADER || data_offset > (uint64_t)snapshot->size ||
+     (uint64_t)size > (uint64_t)snapshot->size - data_offset)
+  {
+    E_FAIL(ID3V2_ERROR_UNSUPPORTED);
+    return 0;
+  }
+
+  memset(frame, 0, sizeof(id3v2_frame));
+  memcpy(frame->id, entry, ID3V2_FRAME_ID);
+  memcpy(frame->flags, entry + ID3V2_FRAME_ID, ID3V2_FRAME_FLAGS);
+  frame->version = entry[6];
+  frame->parsed = entry[7];
+  frame->size = size;
+  frame->data = (char*)(snapshot->data + data_offset);
+  frame->interned = 1;
+
+  E_SUCCESS;
+
+  return 1;
+}
+
+// looks up the first frame with the id in a tag, like id3v2_get_frame_from_tag
+int id3v2_find_frame_in_snapshot(id3v2_snapshot *snapshot, int tag_index, char *frame_id, id3v2_frame *frame)
+{
+  int count = id3v2_get_frame_count_from_snapshot(snapshot, tag_index);
+  int i;
+
+  for(i = 0; i < count && frame_id != NULL; i++)
+  {
+    if(!id3v2_get_frame_from_snapshot(snapshot, tag_index, i, frame))
+      return 0;
+
+    if(memcmp(frame->id, frame_id, ID3V2_DECIDE_FRAME(frame->version, ID3V2_FRAME_ID2, ID3V2_FRAME_ID)) == 0)
+      return 1;
+  }
+
+  E_FAIL(ID3V2_ERROR_NOT_FOUND);
+
+  return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+// counting is off until asked for, so loads only pay for one check of this flag per counter
+volatile int id3v2_stats_enabled = 0;
+
+// like the errors, every thread counts on its own and without any locking
+#if defined(_MSC_VER)
+static __declspec(thread) id3v2_stats thread_stats;
+#elif defined(__GNUC__)
+static __thread id3v2_stats thread_stats;
+#else
+static id3v2_stats thread_stats;
+#endif
+
+id3v2_stats *_get_stats_of_thread()
+{
+  return &thread_stats;
+}
+
+// the library allocates through these, so the allocations show up in the stats
+void *_allocate(size_t size)
+{
+  STATS_ADD(allocations, 1);
+  STATS_ADD(bytes_allocated, (int64_t)size);
+
+  return malloc(size);
+}
+
+void *_allocate_zeroed(size_t count, size_t size)
+{
+  STATS_ADD(allocations, 1);
+  STATS_ADD(bytes_allocated, (int64_t)(count * size));
+
+  return calloc(count, size);
+}
+
+void *_reallocate(void *pointer, size_t size)
+{
+  STATS_ADD(allocations, 1);
+  STATS_ADD(bytes_allocated, (int64_t)size);
+
+  return realloc(pointer, size);
+}
+
+// adds the counters of other to stats, so work done by helper threads shows up in the thread they did it for
+void _add_stats(id3v2_stats *stats, const id3v2_stats *other)
+{
+  stats->bytes_scanned += other->bytes_scanned;
+  stats->headers_parsed += other->headers_parsed;
+  stats->frames_parsed += other->frames_parsed;
+  stats->frames_unparsed += other->frames_unparsed;
+  stats->unsynchronisation_bytes_removed += other->unsynchronisation_bytes_removed;
+  stats->allocations += other->allocations;
+  stats->bytes_allocated += other->bytes_allocated;
+  stats->scan_nanoseconds += other->scan_nanoseconds;
+  stats->frame_nanoseconds += other->frame_nanoseconds;
+  stats->unsynchronisation_nanoseconds += other->unsynchronisation_nanoseconds;
+}
+
+// turns counting on or off for all threads
+void id3v2_enable_stats(int enabled)
+{
+  id3v2_stats_enabled = enabled != 0;
+}
+
+// returns the counters of the calling thread
+void id3v2_get_stats(id3v2_stats *stats)
+{
+  if(stats == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return;
+  }
+
+  *stats = thread_stats;
+
+  E_SUCCESS;
+}
+
+void id3v2_reset_stats()
+{
+  memset(&thread_stats, 0, sizeof(thread_stats));
+}
@@ -0,0 +1,156 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+#define TIMELINE_CURSOR_STEPS 8 // jumps over more entries than that get searched for
+
+typedef struct
+{
+  uint32_t timestamp;
+  int position; // of the entry in the frame
+} timeline_order;
+
+static int _compare_timeline_entries(const void *a, const void *b)
+{
+  const timeline_order *first = (const timeline_order*)a;
+  const timeline_order *second = (const timeline_order*)b;
+
+  if(first->timestamp != second->timestamp)
+    return first->timestamp < second->timestamp ? -1 : 1;
+
+  return first->position - second->position;
+}
+
+// sorts the time stamps along with the values of their entries, value_size bytes each
+// returns 0 if there's no memory for it
+int _sort_timeline(id3v2_timeline *timeline, char *values, int value_size)
+{
+  timeline_order *order;
+  char *sorted_values;
+  int i;
+
+  for(i = 1; i < timeline->count && timeline->timestamps[i - 1] <= timeline->timestamps[i]; i++);
+
+  // writers almost always keep them sorted already
+  if(i >= timeline->count)
+    return 1;
+
+  order = (timeline_order*)_allocate(timeline->count * sizeof(timeline_order));
+  sorted_values = (char*)_allocate(timeline->count * value_size);
+
+  if(order == NULL || sorted_values == NULL)
+  {
+    free(order);
+    free(sorted_values);
+    return 0;
+  }
+
+  for(i = 0; i < timeline->count; i++)
+  {
+    order[i].timestamp = timeline->timestamps[i];
+    order[i].position = i;
+  }
+
+  qsort(order, timeline->count, sizeof(timeline_order), _compare_timeline_entries);
+
+  for(i = 0; i < timeline->count; i++)
+  {
+    timeline->timestamps[i] = order[i].timestamp;
+    memcpy(sorted_values + i * value_size, values + order[i].position * value_size, value_size);
+  }
+
+  memcpy(values, sorted_values, timeline->count * value_size);
+  free(sorted_values);
+  free(order);
+
+  return 1;
+}
+
+// returns the last entry starting at or before the time, -1 if the first one starts after it
+int id3v2_get_entry_at_time_from_timeline(id3v2_timeline *timeline, uint32_t time)
+{
+  int high;
+  int low = 0;
+  int middle;
+
+  if(timeline == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return -1;
+  }
+
+  high = timeline->count;
+  while(low < high)
+  {
+    middle = low + (high - low) / 2;
+    if(timeline->timestamps[middle] <= time)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  E_SUCCESS;
+
+  return low - 1;
+}
+
+void id3v2_initialize_timeline_cursor(id3v2_timeline_cursor *cursor, id3v2_timeline *timeline)
+{
+  if(cursor == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return;
+  }
+
+  cursor->timeline = timeline;
+  cursor->entry = -1;
+
+  E_SUCCESS;
+}
+
+// returns the entry playing at the time like id3v2_get_entry_at_time_from_timeline(),
+// playing forward steps from the last entry to the next ones, seeking searches again
+int id3v2_move_timeline_cursor_to_time(id3v2_timeline_cursor *cursor, uint32_t time)
+{
+  id3v2_timeline *timeline;
+  int steps = 0;
+
+  if(cursor == NULL || cursor->timeline == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return -1;
+  }
+
+  timeline = cursor->timeline;
+
+  if(cursor->entry >= 0 && timeline->timestamps[cursor->entry] > time)
+  {
+    cursor->entry = id3v2_get_entry_at_time_from_timeline(timeline, time);
+    return cursor->entry;
+  }
+
+  while(cursor->entry + 1 < timeline->count && timeline->timestamps[cursor->entry + 1] <= time)
+  {
+    if(++steps > TIMELINE_CURSOR_STEPS)
+    {
+      cursor->entry = id3v2_get_entry_at_time_from_timeline(timeline, time);
+      return cursor->entry;
+    }
+
+    cursor->entry++;
+  }
+
+  E_SUCCESS;
+
+  return cursor->entry;
+}
@@ -0,0 +1,70 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+// shared by all threads, the callback gets events from every one of them
+id3v2_trace_callback id3v2_trace_function = NULL;
+static void *trace_context = NULL;
+
+#ifdef ID3V2_USDT
+// the section tells the tools where to find them
+#define TRACE_SEMAPHORE __attribute__((section(".probes")))
+
+unsigned short id3v2lib_load_start_semaphore TRACE_SEMAPHORE = 0;
+unsigned short id3v2lib_load_end_semaphore TRACE_SEMAPHORE = 0;
+unsigned short id3v2lib_read_semaphore TRACE_SEMAPHORE = 0;
+unsigned short id3v2lib_header_semaphore TRACE_SEMAPHORE = 0;
+unsigned short id3v2lib_frame_semaphore TRACE_SEMAPHORE = 0;
+unsigned short id3v2lib_unsynchronisation_semaphore TRACE_SEMAPHORE = 0;
+#endif
+
+void _trace(int type, int64_t offset, int64_t size, int64_t result, const char *frame_id, int flags, int64_t nanoseconds)
+{
+  id3v2_trace_callback callback = id3v2_trace_function;
+  id3v2_trace_event event;
+
+  if(callback == NULL)
+    return;
+
+  event.type = type;
+  event.offset = offset;
+  event.size = size;
+  event.result = result;
+  event.frame_id = frame_id;
+  event.flags = flags;
+  event.nanoseconds = nanoseconds;
+
+  callback(&event, trace_context);
+}
+
+// copies a frame id of 3 or 4 characters into copy, which takes ID3V2_FRAME_ID + 1 of them, and terminates it
+// returns NULL for events without a frame
+const char *_terminate_trace_frame_id(const char *frame_id, char *copy)
+{
+  if(frame_id == NULL)
+    return NULL;
+
+  memcpy(copy, frame_id, ID3V2_FRAME_ID);
+  copy[ID3V2_FRAME_ID] = '\0';
+
+  return copy;
+}
+
+// calls callback for every trace point passed from now on, NULL stops the tracing again
+// set it before the loads start, events of loads already running may get lost or see the old context
+void id3v2_set_trace_callback(id3v2_trace_callback callback, void *context)
+{
+  id3v2_trace_function = NULL;
+  trace_context = context;
+  id3v2_trace_function = callback;
+}
@@ -15,7 +15,7 @@
 
 id3v2_tag* id3v2_new_tag()
 {
-    id3v2_tag* tag = (id3v2_tag*) malloc(sizeof(id3v2_tag));
+    id3v2_tag* tag = (id3v2_tag*) _allocate(sizeof(id3v2_tag));
 
     if(tag == NULL)
     {
@@ -33,6 +33,10 @@ id3v2_tag* id3v2_new_tag()
     }
 
     tag->frame = NULL;
+    tag->allocations = NULL;
+    tag->allocation_count = 0;
+    tag->index = NULL;
+    tag->chapters = NULL;
 
     E_SUCCESS;
 
@@ -41,7 +45,7 @@ id3v2_tag* id3v2_new_tag()
 
 id3v2_header* _new_header()
 {
-    id3v2_header* tag_header = (id3v2_header*) malloc(sizeof(id3v2_header));
+    id3v2_header* tag_header = (id3v2_header*) _allocate(sizeof(id3v2_header));
     if(tag_header != NULL)
     {
         memset(tag_header->tag, '\0', ID3V2_HEADER_TAG);
@@ -56,7 +60,7 @@ id3v2_header* _new_header()
 
 id3v2_frame* id3v2_new_frame(id3v2_tag *tag, int type)
 {
-    id3v2_frame* frame = (id3v2_frame*) malloc(sizeof(id3v2_frame));
+    id3v2_frame* frame = (id3v2_frame*) _allocate(sizeof(id3v2_frame));
 
     if(frame == NULL)
     {
@@ -72,6 +76,12 @@ id3v2_frame* id3v2_new_frame(id3v2_tag *tag, int type)
 
     frame->parsed = 1;
 
+    frame->interned = 0;
+
+    frame->image = NULL;
+
+    frame->decoded = NULL;
+
     frame->tag = tag;
 
     id3v2_initialize_frame(frame, type);
@@ -86,3 +96,20 @@ id3v2_frame* id3v2_new_frame(id3v2_tag *tag, int type)
 
     return frame;
 }
+
+void id3v2_initialize_load_options(id3v2_load_options *options)
+{
+    if(options == NULL)
+    {
+      E_FAIL(ID3V2_ERROR_NOT_FOUND);
+      return;
+    }
+
+    options->intern_pool = NULL;
+    options->image_cache = NULL;
+    options->deep_scan = 0;
+    options->offset_hint = -1;
+    options->read_histogram = NULL;
+
+    E_SUCCESS;
+}
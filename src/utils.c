@@ -7,9 +7,24 @@
  * file that was distributed with this source code.
  */
 
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // fseeko(), ftello() and pread()
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
 #include "id3v2lib.h"
 
@@ -30,7 +45,7 @@ char* itob(int integer)
 {
     int i;
     int size = 4;
-    char* result = (char*) malloc(sizeof(char) * size);
+    char* result = (char*) _allocate(sizeof(char) * size);
     
     // We need to reverse the bytes because Intel uses little endian.
     char* aux = (char*) &integer;
@@ -44,17 +59,18 @@ char* itob(int integer)
 
 int syncint_encode(int value)
 {
-    int out, mask = 0x7F;
+    // unsigned, since the last mask step overflows an int, which optimizers turn into an endless loop
+    unsigned int out, in = (unsigned int)value, mask = 0x7F;
     
     while (mask ^ 0x7FFFFFFF) {
-        out = value & ~mask;
+        out = in & ~mask;
         out <<= 1;
-        out |= value & mask;
+        out |= in & mask;
         mask = ((mask + 1) << 8) - 1;
-        value = out;
+        in = out;
     }
     
-    return out;
+    return (int)out;
 }
 
 int syncint_decode(int value)
@@ -73,12 +89,37 @@ int syncint_decode(int value)
     return result;
 }
 
+// little endian counterparts of btoi and itob for the library's own binary formats
+void _write_little_endian_to_buffer(char *buffer, uint64_t value, int size)
+{
+    int i;
+
+    for(i = 0; i < size; i++)
+    {
+        buffer[i] = (char)(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+uint64_t _read_little_endian_from_buffer(const char *buffer, int size)
+{
+    uint64_t value = 0;
+    int i;
+
+    for(i = size - 1; i >= 0; i--)
+        value = (value << 8) | (unsigned char)buffer[i];
+
+    return value;
+}
+
 void id3v2_free_tag(id3v2_tag* tag)
 {
     id3v2_frame *frame;
     int i;
     id3v2_frame *next_frame;
 
+    _free_frame_index_of_tag(tag);
+
     free(tag->header);
     frame = tag->frame;
     while(frame != NULL)
@@ -97,6 +138,103 @@ void id3v2_free_tag(id3v2_tag* tag)
     
 }
 
+// 64 bit xxHash of a buffer, used to identify large payloads by their content
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+#define XXH_ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static uint64_t _read_uint64_le(const unsigned char *p)
+{
+    return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+           ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+static uint32_t _read_uint32_le(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t _xxhash64_round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH_PRIME64_2;
+    acc = XXH_ROTL64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+static uint64_t _xxhash64_merge_round(uint64_t acc, uint64_t value)
+{
+    acc ^= _xxhash64_round(0, value);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+uint64_t _xxhash64_buffer(const char *buffer, int size, uint64_t seed)
+{
+    const unsigned char *p = (const unsigned char*)buffer;
+    const unsigned char *end = p + size;
+    uint64_t v1, v2, v3, v4;
+    uint64_t hash;
+
+    if(size >= 32)
+    {
+        // four independent lanes, which lets the compiler keep them all in flight
+        v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        v2 = seed + XXH_PRIME64_2;
+        v3 = seed;
+        v4 = seed - XXH_PRIME64_1;
+
+        do
+        {
+            v1 = _xxhash64_round(v1, _read_uint64_le(p));
+            v2 = _xxhash64_round(v2, _read_uint64_le(p + 8));
+            v3 = _xxhash64_round(v3, _read_uint64_le(p + 16));
+            v4 = _xxhash64_round(v4, _read_uint64_le(p + 24));
+            p += 32;
+        } while(p <= end - 32);
+
+        hash = XXH_ROTL64(v1, 1) + XXH_ROTL64(v2, 7) + XXH_ROTL64(v3, 12) + XXH_ROTL64(v4, 18);
+        hash = _xxhash64_merge_round(hash, v1);
+        hash = _xxhash64_merge_round(hash, v2);
+        hash = _xxhash64_merge_round(hash, v3);
+        hash = _xxhash64_merge_round(hash, v4);
+    }
+    else
+        hash = seed + XXH_PRIME64_5;
+
+    hash += (uint64_t)size;
+
+    while(p + 8 <= end)
+    {
+        hash ^= _xxhash64_round(0, _read_uint64_le(p));
+        hash = XXH_ROTL64(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+        p += 8;
+    }
+
+    if(p + 4 <= end)
+    {
+        hash ^= (uint64_t)_read_uint32_le(p) * XXH_PRIME64_1;
+        hash = XXH_ROTL64(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+
+    while(p < end)
+    {
+        hash ^= (*p) * XXH_PRIME64_5;
+        hash = XXH_ROTL64(hash, 11) * XXH_PRIME64_1;
+        p++;
+    }
+
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME64_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
 // String functions
 int has_bom(char *string)
 {
@@ -109,11 +247,379 @@ int has_bom(char *string)
 }
 
 
+static int _write_utf8_character(unsigned int character, char *utf8)
+{
+    if(character < 0x80)
+    {
+        utf8[0] = (char)character;
+        return 1;
+    }
+    if(character < 0x800)
+    {
+        utf8[0] = (char)(0xC0 | (character >> 6));
+        utf8[1] = (char)(0x80 | (character & 0x3F));
+        return 2;
+    }
+    if(character < 0x10000)
+    {
+        utf8[0] = (char)(0xE0 | (character >> 12));
+        utf8[1] = (char)(0x80 | ((character >> 6) & 0x3F));
+        utf8[2] = (char)(0x80 | (character & 0x3F));
+        return 3;
+    }
+    utf8[0] = (char)(0xF0 | (character >> 18));
+    utf8[1] = (char)(0x80 | ((character >> 12) & 0x3F));
+    utf8[2] = (char)(0x80 | ((character >> 6) & 0x3F));
+    utf8[3] = (char)(0x80 | (character & 0x3F));
+    return 4;
+}
+
+// converts the first string of a text in one of the frame encodings to UTF-8 and returns the amount of bytes written
+// utf8 needs room for twice the size, the string ends at the first terminator or at the end of the text
+int _convert_text_to_utf8(const char *text, int size, char encoding, char *utf8)
+{
+    unsigned int character;
+    char big_endian = 1; // UTF-16 without BOM is big endian
+    int i = 0;
+    unsigned int low;
+    int length = 0;
+
+    if(encoding == ID3V2_ISO_ENCODING)
+    {
+        for(; i < size && text[i] != '\0'; i++)
+            length += _write_utf8_character((unsigned char)text[i], utf8 + length);
+        return length;
+    }
+
+    if(encoding != ID3V2_UTF_16_ENCODING_WITH_BOM && encoding != ID3V2_UTF_16_ENCODING_WITHOUT_BOM)
+    {
+        // UTF-8 already, and anything unknown is copied as well
+        for(; i < size && text[i] != '\0'; i++)
+            utf8[length++] = text[i];
+        return length;
+    }
+
+    if(size >= 2 && has_bom((char*)text))
+    {
+        big_endian = (unsigned char)text[0] == 0xFE;
+        i = 2;
+    }
+
+    for(; i + 1 < size; i += 2)
+    {
+        character = big_endian ? ((unsigned char)text[i] << 8) | (unsigned char)text[i+1]
+                               : ((unsigned char)text[i+1] << 8) | (unsigned char)text[i];
+
+        if(character == 0)
+            break;
+
+        if(character >= 0xD800 && character < 0xDC00 && i + 3 < size)
+        {
+            low = big_endian ? ((unsigned char)text[i+2] << 8) | (unsigned char)text[i+3]
+                             : ((unsigned char)text[i+3] << 8) | (unsigned char)text[i+2];
+
+            if(low >= 0xDC00 && low < 0xE000)
+            {
+                character = 0x10000 + ((character - 0xD800) << 10) + (low - 0xDC00);
+                i += 2;
+            }
+        }
+
+        // unpaired surrogates become the replacement character
+        if(character >= 0xD800 && character < 0xE000)
+            character = 0xFFFD;
+
+        length += _write_utf8_character(character, utf8 + length);
+    }
+
+    return length;
+}
+
 const char *_get_mime_type_from_buffer(char *data, int size)
 {
-  if(data[0]==0xFF && data[1]==0xD8 && data[size-2]==0xFF && data[size-1]==0xD9)
-    return ID3V2_JPG_MIME_TYPE;
-  else if(data[0]==0x89 && data[1]==0x50 && data[2]==0x4E && data[3]==0x47 && data[4]==0x0D && data[5]==0x0A && data[6]==0x1A && data[7]==0x0A)
-    return ID3V2_PNG_MIME_TYPE;
+  // only the magic bytes at the start are inspected, the picture doesn't need to be complete
+  switch(_get_picture_format_from_buffer(data, size))
+  {
+    case ID3V2_PICTURE_FORMAT_JPEG:
+      return ID3V2_JPG_MIME_TYPE;
+    case ID3V2_PICTURE_FORMAT_PNG:
+      return ID3V2_PNG_MIME_TYPE;
+    case ID3V2_PICTURE_FORMAT_GIF:
+      return ID3V2_GIF_MIME_TYPE;
+    case ID3V2_PICTURE_FORMAT_BMP:
+      return ID3V2_BMP_MIME_TYPE;
+    case ID3V2_PICTURE_FORMAT_WEBP:
+      return ID3V2_WEBP_MIME_TYPE;
+  }
   return "";
-}
\ No newline at end of file
+}
+
+// File functions
+// fseek() and ftell() are limited to long, which is 32 bit on Windows and 32 bit systems
+int _seek_in_file(FILE *file, int64_t offset, int origin)
+{
+#ifdef _WIN32
+  return _fseeki64(file, offset, origin);
+#else
+  return fseeko(file, (off_t)offset, origin);
+#endif
+}
+
+int64_t _get_position_in_file(FILE *file)
+{
+#ifdef _WIN32
+  return _ftelli64(file);
+#else
+  return (int64_t)ftello(file);
+#endif
+}
+
+// returns the length of the file or -1, the position is left at the end of the file
+int64_t _get_length_of_file(FILE *file)
+{
+  if(_seek_in_file(file, 0, SEEK_END) != 0)
+    return -1;
+
+  return _get_position_in_file(file);
+}
+
+// reads size bytes at offset without touching the position of the descriptor, so threads can share it
+// returns the amount of bytes read, which is only less than size at the end of the file or on errors
+int _read_from_fd(int fd, int64_t offset, char *buffer, int size)
+{
+  int done = 0;
+#ifdef _WIN32
+  DWORD chunk;
+  OVERLAPPED position;
+  HANDLE handle = (HANDLE)_get_osfhandle(fd);
+
+  if(handle == INVALID_HANDLE_VALUE)
+    return 0;
+#else
+  ssize_t chunk;
+#endif
+
+  while(done < size)
+  {
+#ifdef _WIN32
+    memset(&position, 0, sizeof(position));
+    position.Offset = (DWORD)((offset + done) & 0xFFFFFFFF);
+    position.OffsetHigh = (DWORD)((offset + done) >> 32);
+    if(!ReadFile(handle, buffer + done, size - done, &chunk, &position) || chunk == 0)
+      break;
+#else
+    chunk = pread(fd, buffer + done, size - done, (off_t)(offset + done));
+    if(chunk <= 0)
+      break;
+#endif
+    done += (int)chunk;
+  }
+
+  return done;
+}
+
+int64_t _get_length_of_fd(int fd)
+{
+#ifdef _WIN32
+  struct _stati64 status;
+
+  if(_fstati64(fd, &status) != 0)
+    return -1;
+#else
+  struct stat status;
+
+  if(fstat(fd, &status) != 0)
+    return -1;
+#endif
+
+  return (int64_t)status.st_size;
+}
+
+// the counterpart of _read_from_fd, returns the amount of bytes written
+int _write_to_fd(int fd, int64_t offset, const char *buffer, int size)
+{
+  int done = 0;
+#ifdef _WIN32
+  DWORD chunk;
+  OVERLAPPED position;
+  HANDLE handle = (HANDLE)_get_osfhandle(fd);
+
+  if(handle == INVALID_HANDLE_VALUE)
+    return 0;
+#else
+  ssize_t chunk;
+#endif
+
+  while(done < size)
+  {
+#ifdef _WIN32
+    memset(&position, 0, sizeof(position));
+    position.Offset = (DWORD)((offset + done) & 0xFFFFFFFF);
+    position.OffsetHigh = (DWORD)((offset + done) >> 32);
+    if(!WriteFile(handle, buffer + done, size - done, &chunk, &position) || chunk == 0)
+      break;
+#else
+    chunk = pwrite(fd, buffer + done, size - done, (off_t)(offset + done));
+    if(chunk <= 0)
+      break;
+#endif
+    done += (int)chunk;
+  }
+
+  return done;
+}
+
+// Time functions
+// nanoseconds from an arbitrary point in the past, only useful for measuring durations
+int64_t _get_monotonic_nanoseconds()
+{
+#ifdef _WIN32
+  LARGE_INTEGER counter;
+  LARGE_INTEGER frequency;
+
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+
+  return (int64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+// Thread functions
+// those are only used internally to spread work over several threads
+typedef struct
+{
+  void (*routine)(void *argument);
+  void *argument;
+#ifdef _WIN32
+  HANDLE handle;
+#else
+  pthread_t handle;
+#endif
+} thread_start;
+
+#ifdef _WIN32
+static DWORD WINAPI _run_thread(LPVOID parameter)
+{
+  thread_start *start = (thread_start*)parameter;
+
+  start->routine(start->argument);
+
+  return 0;
+}
+#else
+static void *_run_thread(void *parameter)
+{
+  thread_start *start = (thread_start*)parameter;
+
+  start->routine(start->argument);
+
+  return NULL;
+}
+#endif
+
+// returns a handle for _join_thread or NULL if the thread couldn't be started
+void *_start_thread(void (*routine)(void *argument), void *argument)
+{
+  thread_start *start = (thread_start*)_allocate(sizeof(thread_start));
+
+  if(start == NULL)
+    return NULL;
+
+  start->routine = routine;
+  start->argument = argument;
+
+#ifdef _WIN32
+  start->handle = CreateThread(NULL, 0, _run_thread, start, 0, NULL);
+  if(start->handle == NULL)
+#else
+  if(pthread_create(&start->handle, NULL, _run_thread, start) != 0)
+#endif
+  {
+    free(start);
+    return NULL;
+  }
+
+  return start;
+}
+
+void _join_thread(void *thread)
+{
+  thread_start *start = (thread_start*)thread;
+
+  if(start == NULL)
+    return;
+
+#ifdef _WIN32
+  WaitForSingleObject(start->handle, INFINITE);
+  CloseHandle(start->handle);
+#else
+  pthread_join(start->handle, NULL);
+#endif
+
+  free(start);
+}
+
+// Mutex functions
+// those are only used internally to guard structures which may be shared between threads
+void *_new_mutex()
+{
+#ifdef _WIN32
+  CRITICAL_SECTION *mutex = (CRITICAL_SECTION*)_allocate(sizeof(CRITICAL_SECTION));
+
+  if(mutex == NULL)
+    return NULL;
+
+  InitializeCriticalSection(mutex);
+#else
+  pthread_mutex_t *mutex = (pthread_mutex_t*)_allocate(sizeof(pthread_mutex_t));
+
+  if(mutex == NULL)
+    return NULL;
+
+  if(pthread_mutex_init(mutex, NULL) != 0)
+  {
+    free(mutex);
+    return NULL;
+  }
+#endif
+
+  return mutex;
+}
+
+void _lock_mutex(void *mutex)
+{
+#ifdef _WIN32
+  EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#else
+  pthread_mutex_lock((pthread_mutex_t*)mutex);
+#endif
+}
+
+void _unlock_mutex(void *mutex)
+{
+#ifdef _WIN32
+  LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#else
+  pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+}
+
+void _free_mutex(void *mutex)
+{
+  if(mutex == NULL)
+    return;
+
+#ifdef _WIN32
+  DeleteCriticalSection((CRITICAL_SECTION*)mutex);
+#else
+  pthread_mutex_destroy((pthread_mutex_t*)mutex);
+#endif
+
+  free(mutex);
+}
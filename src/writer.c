@@ -0,0 +1,134 @@
+/*
+ * This file is part of the id3v2lib library
+ *
+ * Copyright (c) 2013, Lorenzo Ruiz
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3v2lib.h"
+
+static void _write_integer_to_buffer(char *buffer, unsigned int value, int size)
+{
+  int i;
+
+  for(i = size - 1; i >= 0; i--)
+  {
+    buffer[i] = (char)(value & 0xFF);
+    value >>= 8;
+  }
+}
+
+// returns the amount of bytes the frame takes up in a tag, its header included
+int _get_size_of_frame_in_tag(id3v2_frame *frame)
+{
+  char *picture;
+  int picture_size = 0;
+
+  if(frame->image != NULL)
+    _get_picture_from_cached_image(frame->image, &picture, &picture_size);
+
+  return ID3V2_DECIDE_FRAME(frame->version, ID3V2_FRAME_ID2 + ID3V2_FRAME_SIZE2, ID3V2_FRAME_ID + ID3V2_FRAME_SIZE + ID3V2_FRAME_FLAGS) +
+         frame->size + picture_size;
+}
+
+// writes the frame the way it is stored in a tag and returns the amount of bytes written
+// the data is written as parsed, so it isn't unsynchronized anymore
+int _write_frame_to_buffer(id3v2_frame *frame, char *buffer)
+{
+  char *picture;
+  int picture_size = 0;
+  int position = 0;
+
+  if(frame->image != NULL)
+    _get_picture_from_cached_image(frame->image, &picture, &picture_size);
+
+  if(frame->version == ID3V2_2)
+  {
+    memcpy(buffer, frame->id, ID3V2_FRAME_ID2);
+    _write_integer_to_buffer(buffer + ID3V2_FRAME_ID2, frame->size + picture_size, ID3V2_FRAME_SIZE2);
+    position = ID3V2_FRAME_ID2 + ID3V2_FRAME_SIZE2;
+  }
+  else
+  {
+    memcpy(buffer, frame->id, ID3V2_FRAME_ID);
+    _write_integer_to_buffer(buffer + ID3V2_FRAME_ID,
+                             frame->version == ID3V2_4 ? syncint_encode(frame->size + picture_size) : frame->size + picture_size,
+                             ID3V2_FRAME_SIZE);
+    buffer[ID3V2_FRAME_ID + ID3V2_FRAME_SIZE] = frame->flags[0];
+    // the data got synchronized when it was parsed, so unsynchronization mustn't be reversed again
+    // the data length indicator stays, since its 4 bytes are still at the start of the data
+    buffer[ID3V2_FRAME_ID + ID3V2_FRAME_SIZE + 1] = frame->flags[1] & ~0x02;
+    position = ID3V2_FRAME_ID + ID3V2_FRAME_SIZE + ID3V2_FRAME_FLAGS;
+  }
+
+  memcpy(buffer + position, frame->data, frame->size);
+  position += frame->size;
+
+  if(picture_size > 0)
+  {
+    memcpy(buffer + position, picture, picture_size);
+    position += picture_size;
+  }
+
+  return position;
+}
+
+// serializes the tag, which id3v2_load_tag_from_buffer turns back into the same frames
+// returns a buffer the caller has to free or NULL
+char *id3v2_write_tag_to_buffer(id3v2_tag *tag, size_t *size)
+{
+  char *buffer;
+  id3v2_frame *frame;
+  size_t position;
+  size_t tag_size = 0;
+
+  *size = 0;
+
+  if(tag == NULL || tag->header == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_NOT_FOUND);
+    return NULL;
+  }
+
+  for(frame = tag->frame; frame != NULL; frame = frame->next)
+    tag_size += _get_size_of_frame_in_tag(frame);
+
+  // the size has to fit the 28 bits of a synchsafe integer
+  if(tag_size > 0x0FFFFFFF)
+  {
+    E_FAIL(ID3V2_ERROR_UNSUPPORTED);
+    return NULL;
+  }
+
+  buffer = (char*)_allocate((ID3V2_HEADER + tag_size) * sizeof(char));
+
+  if(buffer == NULL)
+  {
+    E_FAIL(ID3V2_ERROR_MEMORY_ALLOCATION);
+    return NULL;
+  }
+
+  // neither an extended header, nor a footer nor unsynchronization
+  memcpy(buffer, "ID3", ID3V2_HEADER_TAG);
+  buffer[ID3V2_HEADER_TAG] = tag->header->major_version;
+  buffer[ID3V2_HEADER_TAG + ID3V2_HEADER_VERSION] = tag->header->minor_version;
+  buffer[ID3V2_HEADER_TAG + ID3V2_HEADER_VERSION + ID3V2_HEADER_REVISION] = 0;
+  _write_integer_to_buffer(buffer + ID3V2_HEADER - ID3V2_HEADER_SIZE, syncint_encode((int)tag_size), ID3V2_HEADER_SIZE);
+
+  position = ID3V2_HEADER;
+
+  for(frame = tag->frame; frame != NULL; frame = frame->next)
+    position += _write_frame_to_buffer(frame, buffer + position);
+
+  *size = position;
+
+  E_SUCCESS;
+
+  return buffer;
+}